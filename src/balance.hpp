@@ -0,0 +1,69 @@
+/**
+ * @file   balance.hpp
+ * @brief  It contains the adaptive repartitioning: the chunk boundaries move towards the faster workers
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_BALANCE_HPP
+#define ODD_EVEN_SORT_BALANCE_HPP
+
+#include <algorithm> // std::min_element, std::max_element
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Busy times closer than this fraction are balanced enough: the boundaries don't move for the noise
+double constexpr balance_tolerance = 0.02;
+
+/**
+ * @brief It moves the chunk boundaries by the speed of the workers in the last period: every worker gets
+ *        the elements it sorted in the mean busy time, halfway from the current boundaries (to damp the noise).
+ *        A boundary moves only by an even number of elements: the parity of every chunk start (the offset
+ *        flag of its worker) never changes. If a chunk would get less than two pairs, nothing moves.
+ *        The result depends only on the arguments, so every worker can compute it by itself.
+ *
+ * @param starts the first element of every worker, and the last element of the array (the chunk i is
+ *               [starts[i], starts[i + 1]], the boundary element included)
+ * @param busy the busy time (computing, not waiting) of every worker
+ * @param stride the distance between the busy times of two workers
+ * @return true if the boundaries moved
+ */
+inline bool rebalance(std::vector<size_t> &starts, uint64_t const *busy, size_t const stride) {
+    auto const nw = starts.size() - 1;
+    if (nw < 2)
+        return false;
+
+    std::vector<double> speeds(nw);
+    uint64_t fastest = UINT64_MAX, slowest = 0;
+    double total = 0;
+    for (size_t i = 0; i < nw; ++i) {
+        auto const time = std::max<uint64_t>(busy[i * stride], 1);
+        fastest = std::min(fastest, time);
+        slowest = std::max(slowest, time);
+        speeds[i] = static_cast<double>(starts[i + 1] - starts[i]) / time;
+        total += speeds[i];
+    }
+    if (slowest - fastest < balance_tolerance * slowest)
+        return false;
+
+    auto moved = starts;
+    double target = 0;
+    auto const length = static_cast<double>(starts[nw] - starts[0]);
+    for (size_t i = 1; i < nw; ++i) {
+        target += length * speeds[i - 1] / total;
+        auto const goal = static_cast<double>(starts[0]) + target;
+        auto const halfway = static_cast<long>((goal + starts[i]) / 2);
+        auto const delta = (halfway - static_cast<long>(starts[i])) & ~1L; // Even, rounded down
+        auto const boundary = static_cast<long>(starts[i]) + delta;
+        if (boundary < static_cast<long>(moved[i - 1]) + 2)
+            return false;
+        moved[i] = boundary;
+    }
+    if (moved[nw] < moved[nw - 1] + 2 || moved == starts)
+        return false;
+    starts = moved;
+    return true;
+}
+
+#endif // ODD_EVEN_SORT_BALANCE_HPP
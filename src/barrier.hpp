@@ -1,6 +1,6 @@
 /**
  * @file   barrier.hpp
- * @brief  It describes an atomic barrier for threads synchronization
+ * @brief  It describes and implements the reusable atomic barriers for threads synchronization
  * @author Michele Zoncheddu
  */
 
@@ -8,20 +8,312 @@
 #ifndef ODD_EVEN_SORT_BARRIER_HPP
 #define ODD_EVEN_SORT_BARRIER_HPP
 
+#include <algorithm> // std::min
 #include <atomic>
+#include <cstdlib>   // std::abort
+#include <memory>    // std::unique_ptr
+#include <string>
+#include <vector>
 
+#include <wait.hpp>
+
+/**
+ * The barrier interface: n participants, identified from 0 to n - 1, and reusable for any number of episodes.
+ * The last participant (n - 1) is the controller: read() is meaningful only before it arrives.
+ */
 class barrier {
+   protected:
+    wait_policy const policy;
+
+   public:
+    explicit barrier(wait_policy policy) : policy{policy} {}
+
+    virtual ~barrier() = default;
+
+    /**
+     * @brief It arrives at the barrier without waiting. Use it only as the last arrival of the episode.
+     *
+     * @param id the participant identifier
+     */
+    virtual void dec(int id) = 0;
+
+    /**
+     * @brief It arrives at the barrier and waits for the other participants.
+     *
+     * @param id the participant identifier
+     */
+    virtual void wait(int id) = 0;
+
+    /**
+     * @return the number of arrivals still missing in the current episode (at least one, the controller)
+     */
+    virtual int read() = 0;
+
+    /**
+     * @brief It arrives at the current episode without waiting, and it's not waited in the next ones.
+     *        Only the central barrier has a variable number of participants.
+     *
+     * @param id the participant identifier
+     */
+    virtual void leave(int id) {
+        (void) id;
+        std::abort();
+    }
+
+    /**
+     * @brief It brings back a participant that left, from the current episode. The caller must be
+     *        a participant that has not arrived yet, so the episode can't end meanwhile.
+     *
+     * @param id the identifier of the participant that comes back
+     */
+    virtual void join(int id) {
+        (void) id;
+        std::abort();
+    }
+};
+
+/**
+ * Centralized sense-reversing barrier: a shared counter, and a generation number that works as the sense.
+ * The participants can leave and join: the counter restarts from the current number of participants.
+ */
+class central_barrier : public barrier {
    private:
     std::atomic<int> n;
+    std::atomic<int> count;
+    std::atomic<unsigned> generation;
+
+    bool arrive();
+
+   public:
+    central_barrier(int, wait_policy);
+
+    void dec(int) override;
+
+    void wait(int) override;
+
+    int read() override;
+
+    void leave(int) override;
+
+    void join(int) override;
+};
+
+/**
+ * Combining tree barrier: the workers arrive on the leaves, and the last arrival of a node goes up to its parent.
+ * The controller arrives directly on the root, so read() counts the pending subtrees of the root.
+ */
+class tree_barrier : public barrier {
+   private:
+    struct node {
+        std::atomic<int> count;
+        int size;
+        int parent;
+        char padding[64 - 3 * sizeof(int)]; // One node per cache line
+    };
+
+    int const n;
+    int const arity;
+    std::vector<std::unique_ptr<node>> nodes; // The root is the last one
+    std::atomic<unsigned> generation;
+
+    bool arrive(int);
+
+   public:
+    tree_barrier(int, wait_policy, int arity = 4);
+
+    void dec(int) override;
+
+    void wait(int) override;
+
+    int read() override;
+};
+
+/**
+ * Dissemination barrier: in the round r, the participant i signals (i + 2^r) % n and waits for (i - 2^r) % n.
+ * The flags are episode counters, so they never need to be reset.
+ */
+class dissemination_barrier : public barrier {
+   private:
+    struct slot {
+        std::atomic<unsigned> value;
+        char padding[64 - sizeof(unsigned)]; // One slot per cache line
+    };
+
+    int const n;
+    int rounds;
+    std::unique_ptr<slot[]> flags;   // n * rounds flags
+    std::unique_ptr<slot[]> arrived; // The episodes of every participant
 
    public:
-    explicit barrier(int);
+    dissemination_barrier(int, wait_policy);
 
-    void dec();
+    void dec(int) override;
 
-    void wait();
+    void wait(int) override;
 
-    int read();
+    int read() override;
 };
 
+
+inline central_barrier::central_barrier(int n, wait_policy policy) : barrier{policy}, n{n}, count{n}, generation{0} {}
+
+/**
+ * @brief It decrements the counter: the last arrival resets it and releases the others.
+ *
+ * @return true if this was the last arrival
+ */
+inline bool central_barrier::arrive() {
+    if (--count != 0)
+        return false;
+    count = n.load(); // Ready for the next episode, nobody can arrive before the generation change
+    ++generation;
+    notify_all(word_of(generation), policy);
+    return true;
+}
+
+inline void central_barrier::dec(int) {
+    arrive();
+}
+
+inline void central_barrier::wait(int) {
+    unsigned const my_generation = generation; // Read before arriving: it can't change before my arrival
+    if (!arrive())
+        wait_until(word_of(generation), [=](unsigned value) { return value != my_generation; }, policy);
+}
+
+inline int central_barrier::read() {
+    return count;
+}
+
+/**
+ * The participants decrease before the arrival: if it's the last one, the next episode already waits one less.
+ */
+inline void central_barrier::leave(int) {
+    --n;
+    arrive();
+}
+
+inline void central_barrier::join(int) {
+    ++n;
+    ++count;
+}
+
+inline tree_barrier::tree_barrier(int n, wait_policy policy, int arity)
+        : barrier{policy}, n{n}, arity{arity}, generation{0} {
+    // The leaves, for the workers
+    int level_size = n - 1, first = 0;
+    do {
+        int const nodes_in_level = (level_size + arity - 1) / arity;
+        for (int i = 0; i < nodes_in_level; ++i) {
+            nodes.push_back(std::make_unique<node>());
+            nodes.back()->size = std::min(arity, level_size - i * arity);
+        }
+        // The nodes of the previous level point to the new ones
+        if (first > 0)
+            for (int i = 0; i < level_size; ++i)
+                nodes[first - level_size + i]->parent = first + i / arity;
+        first += nodes_in_level;
+        level_size = nodes_in_level;
+    } while (level_size > 1);
+    if (nodes.empty()) // No workers: the root only
+        nodes.push_back(std::make_unique<node>());
+
+    nodes.back()->size++; // The controller
+    nodes.back()->parent = -1;
+    for (auto &elem : nodes)
+        elem->count = elem->size;
+}
+
+/**
+ * @brief It decrements the counters from the leaf of the participant, going up while it's the last arrival.
+ *
+ * @param id the participant identifier
+ * @return true if this was the last arrival of the whole tree
+ */
+inline bool tree_barrier::arrive(int id) {
+    int current = id == n - 1 ? static_cast<int>(nodes.size()) - 1 : id / arity;
+    while (--nodes[current]->count == 0) {
+        nodes[current]->count = nodes[current]->size;
+        current = nodes[current]->parent;
+        if (current < 0) {
+            ++generation;
+            notify_all(word_of(generation), policy);
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void tree_barrier::dec(int id) {
+    arrive(id);
+}
+
+inline void tree_barrier::wait(int id) {
+    unsigned const my_generation = generation;
+    if (!arrive(id))
+        wait_until(word_of(generation), [=](unsigned value) { return value != my_generation; }, policy);
+}
+
+inline int tree_barrier::read() {
+    return nodes.back()->count;
+}
+
+inline dissemination_barrier::dissemination_barrier(int n, wait_policy policy) : barrier{policy}, n{n}, rounds{0} {
+    while ((1 << rounds) < n)
+        ++rounds;
+    flags   = std::make_unique<slot[]>(n * rounds);
+    arrived = std::make_unique<slot[]>(n);
+    for (int i = 0; i < n * rounds; ++i)
+        flags[i].value = 0;
+    for (int i = 0; i < n; ++i)
+        arrived[i].value = 0;
+}
+
+/**
+ * The last arrival doesn't wait anyway: every other participant has already signalled its partners.
+ */
+inline void dissemination_barrier::dec(int id) {
+    wait(id);
+}
+
+inline void dissemination_barrier::wait(int id) {
+    unsigned const episode = arrived[id].value + 1;
+    arrived[id].value = episode;
+    for (int r = 0; r < rounds; ++r) {
+        auto &partner = flags[((id + (1 << r)) % n) * rounds + r].value;
+        ++partner;
+        notify_all(word_of(partner), policy);
+        wait_until(word_of(flags[id * rounds + r].value), [=](unsigned value) { return value >= episode; }, policy);
+    }
+}
+
+/**
+ * The current episode is the next one of the controller, that has not arrived yet.
+ */
+inline int dissemination_barrier::read() {
+    unsigned const episode = arrived[n - 1].value + 1;
+    int missing = 0;
+    for (int i = 0; i < n; ++i)
+        missing += arrived[i].value < episode;
+    return missing;
+}
+
+/**
+ * @brief It creates a barrier.
+ *
+ * @param kind the implementation: "central", "tree" or "dissemination"
+ * @param n the number of participants
+ * @param policy how the participants wait
+ * @return the barrier, or nullptr if the kind is unknown
+ */
+inline std::unique_ptr<barrier> make_barrier(std::string const &kind, int n, wait_policy policy = wait_policy::spin) {
+    if (kind == "central")
+        return std::make_unique<central_barrier>(n, policy);
+    if (kind == "tree")
+        return std::make_unique<tree_barrier>(n, policy);
+    if (kind == "dissemination")
+        return std::make_unique<dissemination_barrier>(n, policy);
+    return nullptr;
+}
+
 #endif // ODD_EVEN_SORT_BARRIER_HPP
@@ -0,0 +1,194 @@
+/**
+ * @file   batch.hpp
+ * @brief  It contains the batch sort of many small arrays: the arrays of a batch are transposed,
+ *         an array per vector lane, and sorted by the same odd-even phases in lockstep
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_BATCH_HPP
+#define ODD_EVEN_SORT_BATCH_HPP
+
+#include <algorithm> // std::max_element, std::min, std::max
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>    // Smart pointers
+#include <thread>
+#include <vector>
+
+#include <oddeven.hpp>
+#include <placement.hpp>
+#include <sequential.hpp>
+
+// The lengths are padded to a multiple of this: the arrays of a bucket are sorted together
+size_t constexpr batch_bucket = 16;
+
+// Longer arrays are sorted alone, phase by phase
+size_t constexpr batch_max_length = 4096;
+
+/**
+ * @return the arrays of a batch: a row of a cache line, that the compiler maps on one or two vector registers
+ */
+template <typename T>
+constexpr size_t batch_lanes() {
+    return sizeof(T) < 64 ? 64 / sizeof(T) : 1;
+}
+
+/**
+ * @brief It performs an odd and an even sorting phase on every lane of a transposed batch, in one sweep:
+ *        the row j holds the element j of every array, and the pairs are rows. The even pair (j, j + 1)
+ *        follows the odd pair (j + 1, j + 2), so the three rows are loaded and stored once for both phases.
+ *        The inner loops have a constant trip count and no branches: they're vectorized by the compiler.
+ *
+ * @tparam T the element type
+ * @tparam Lanes the arrays of the batch
+ * @param rows the batch, length rows of Lanes elements
+ * @param length the padded length of the arrays
+ * @return non-zero if at least one swap has been performed
+ */
+template <typename T, size_t Lanes>
+unsigned batch_sweep(T * const rows, size_t const length) {
+    uint32_t changed[Lanes] = {};
+    size_t j = 0;
+    for (; j + 2 < length; j += 2) {
+        T * __restrict const r0 = rows + j * Lanes;
+        T * __restrict const r1 = r0 + Lanes;
+        T * __restrict const r2 = r1 + Lanes;
+        for (size_t a = 0; a < Lanes; ++a) {
+            T const x = r0[a], y = r1[a], z = r2[a];
+            T const odd_lo = z < y ? z : y; // Odd pair
+            T const odd_hi = z < y ? y : z;
+            changed[a] |= (z < y ? 1u : 0u) | (odd_lo < x ? 1u : 0u);
+            r0[a] = odd_lo < x ? odd_lo : x; // Even pair
+            r1[a] = odd_lo < x ? x : odd_lo;
+            r2[a] = odd_hi;
+        }
+    }
+    if (j + 1 < length) { // The last even pair, without an odd pair after it
+        T * __restrict const r0 = rows + j * Lanes;
+        T * __restrict const r1 = r0 + Lanes;
+        for (size_t a = 0; a < Lanes; ++a) {
+            T const x = r0[a], y = r1[a];
+            changed[a] |= y < x ? 1u : 0u;
+            r0[a] = y < x ? y : x;
+            r1[a] = y < x ? x : y;
+        }
+    }
+    uint32_t any = 0;
+    for (size_t a = 0; a < Lanes; ++a)
+        any |= changed[a];
+    return any;
+}
+
+/**
+ * @brief It sorts a batch: it transposes the arrays in the rows, it runs the sweeps until no lane swaps,
+ *        and it transposes the arrays back. Every array is padded with copies of its maximum, that stay
+ *        at its end; the lanes without an array copy the first one, and they are not written back.
+ *
+ * @tparam T the element type
+ * @param arrays the arrays
+ * @param lengths their lengths
+ * @param members the arrays of the batch, at most batch_lanes
+ * @param count the number of members
+ * @param length the padded length
+ * @param rows the buffer of the batch, at least length rows
+ */
+template <typename T>
+void sort_batch_rows(T * const *arrays, size_t const *lengths, size_t const *members, size_t const count,
+                     size_t const length, std::vector<T> &rows) {
+    size_t constexpr lanes = batch_lanes<T>();
+    for (size_t a = 0; a < lanes; ++a) {
+        auto const m = members[a < count ? a : 0];
+        auto const v = arrays[m];
+        auto const len = lengths[m];
+        auto const top = *std::max_element(v, v + len);
+        for (size_t j = 0; j < length; ++j)
+            rows[j * lanes + a] = j < len ? v[j] : top;
+    }
+
+    unsigned swaps;
+    do {
+        swaps = batch_sweep<T, lanes>(rows.data(), length); // An odd and an even phase
+    } while (swaps);
+
+    for (size_t a = 0; a < count; ++a) {
+        auto const v = arrays[members[a]];
+        for (size_t j = 0; j < lengths[members[a]]; ++j)
+            v[j] = rows[j * lanes + a];
+    }
+}
+
+namespace oddeven {
+
+/**
+ * @brief It sorts many independent arrays in place. The arrays are grouped by their length, padded to
+ *        a multiple of batch_bucket, and sorted batch_lanes at a time (see sort_batch_rows); the arrays
+ *        longer than batch_max_length are sorted alone. The batches are taken by policy.nw pinned threads
+ *        (the calling thread, with the sequential engine).
+ *
+ * @tparam T the element type
+ * @param arrays the arrays
+ * @param lengths their lengths
+ * @param count the number of arrays
+ * @param p the policy, that must be valid (see validate): only the number of threads and their pinning count
+ */
+template <typename T>
+void sort_batch(T * const *arrays, size_t const *lengths, size_t const count, policy const &p = policy{}) {
+    size_t constexpr lanes = batch_lanes<T>();
+
+    // The jobs: a batch of a bucket, or a long array alone (no members)
+    struct job {
+        size_t length;
+        std::vector<size_t> members;
+        size_t alone;
+    };
+    std::map<size_t, std::vector<size_t>> buckets;
+    std::vector<job> jobs;
+    for (size_t i = 0; i < count; ++i) {
+        if (lengths[i] > batch_max_length)
+            jobs.push_back(job{lengths[i], {}, i});
+        else if (lengths[i] > 1)
+            buckets[(lengths[i] + batch_bucket - 1) / batch_bucket * batch_bucket].push_back(i);
+    }
+    for (auto const &bucket : buckets)
+        for (size_t first = 0; first < bucket.second.size(); first += lanes) {
+            auto const last = std::min(first + lanes, bucket.second.size());
+            jobs.push_back(job{bucket.first, {bucket.second.begin() + first, bucket.second.begin() + last}, 0});
+        }
+
+    std::atomic<size_t> next{0};
+    auto const work = [&] {
+        std::vector<T> rows;
+        for (size_t k; (k = next++) < jobs.size();) {
+            auto const &current = jobs[k];
+            if (current.members.empty()) {
+                sequential_sort(arrays[current.alone], current.length, 0);
+                continue;
+            }
+            rows.resize(std::max(rows.size(), current.length * lanes));
+            sort_batch_rows(arrays, lengths, current.members.data(), current.members.size(), current.length, rows);
+        }
+    };
+
+    auto const nw = p.engine == engine::sequential ? 1 : static_cast<int>(std::min<size_t>(p.nw, jobs.size()));
+    if (nw <= 1) {
+        work();
+        return;
+    }
+    std::vector<std::unique_ptr<std::thread>> workers;
+    for (int i = 0; i < nw; ++i)
+        workers.push_back(std::make_unique<std::thread>(work));
+    if (p.pinning) {
+        auto const where = place_threads(nw, p.placement);
+        for (int i = 0; i < nw; ++i)
+            detail::pin(workers[i]->native_handle(), where.workers[i]);
+    }
+    for (auto &thread : workers)
+        thread->join();
+}
+
+} // namespace oddeven
+
+#endif // ODD_EVEN_SORT_BATCH_HPP
@@ -0,0 +1,156 @@
+/**
+ * @file   batcher.hpp
+ * @brief  It contains the Batcher odd-even merge sort engine: the same compare-exchanges of the odd-even sort,
+ *         arranged in O(log^2 n) stages instead of n phases
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_BATCHER_HPP
+#define ODD_EVEN_SORT_BATCHER_HPP
+
+#include <algorithm> // std::min, std::max
+#include <cstddef>
+#include <vector>
+
+#include <kernel.hpp>
+#include <metrics.hpp>
+#include <native.hpp>
+
+/**
+ * @brief It compare-exchanges two runs, element by element: the lower elements go to the first run.
+ *        The runs don't overlap and the loop has no branches, so it's vectorized by the compiler.
+ *
+ * @tparam T the element type
+ * @param a the first run
+ * @param b the second run
+ * @param len the length of the runs
+ */
+template <typename T>
+void compare_exchange_runs(T * __restrict const a, T * __restrict const b, size_t const len) {
+    for (size_t i = 0; i < len; ++i) {
+        T const x = a[i], y = b[i];
+        a[i] = y < x ? y : x;
+        b[i] = y < x ? x : y;
+    }
+}
+
+/**
+ * @brief It performs the comparators of a stage of the network that start in [from, to).
+ *        The stage (p, k) merges the sorted runs of p elements in pairs, comparing the elements at distance k:
+ *        its comparators come in runs of k, each one inside a merge (2 p elements) or dropped whole.
+ *        The network is the one of the next power of two, without the comparators past the array end.
+ *        With k = 1 the runs are single pairs: inside a merge they are an odd phase, run by the odd-even kernel.
+ *
+ * @tparam T the element type
+ * @param v the pointer to the vector
+ * @param n the number of elements
+ * @param p the length of the merged runs
+ * @param k the comparator distance, from p down to 1
+ * @param from the first comparator of the worker
+ * @param to past the last comparator of the worker (even, or n)
+ */
+template <typename T>
+void batcher_stage(T * const v, size_t const n, size_t const p, size_t const k, size_t const from, size_t const to) {
+    if (k == 1) {
+        if (p == 1) { // The even phase
+            if (std::min(to, n - 1) > from)
+                odd_even_sort(v + from, 0, std::min(to, n - 1) - from);
+            return;
+        }
+        for (size_t b = from / (2 * p) * (2 * p); b < to && b + 1 < n; b += 2 * p) { // The odd phase of a merge
+            auto const first = std::max(b, from); // Even: the odd positions stay odd
+            auto const last  = std::min({b + 2 * p - 2, to, n - 1});
+            if (last > first)
+                odd_even_sort(v + first, 1, last - first);
+        }
+        return;
+    }
+
+    size_t j = k % p; // The first run
+    if (from > j)
+        j += (from - j) / (2 * k) * (2 * k);
+    for (; j < to && j + k < n; j += 2 * k) {
+        if (j / (2 * p) != (j + k) / (2 * p)) // Across two merges
+            continue;
+        auto const first = std::max(j, from);
+        auto const last  = std::min({j + k, to, n - k});
+        if (last > first)
+            compare_exchange_runs(v + first, v + first + k, last - first);
+    }
+}
+
+/**
+ * @brief It splits the comparators of the stages among the workers, on the boundaries of the local blocks.
+ *
+ * @param n the number of elements
+ * @param nw the number of workers
+ * @param block the length of the local blocks (a power of two)
+ * @return the first comparator of every worker, and n
+ */
+inline std::vector<size_t> batcher_starts(size_t const n, int const nw, size_t const block) {
+    std::vector<size_t> starts(nw + 1);
+    for (int i = 1; i < nw; ++i)
+        starts[i] = n / nw * i / block * block;
+    starts[nw] = n;
+    return starts;
+}
+
+/**
+ * @return the length of the blocks sorted by a worker alone: a power of two, at most a quarter of a chunk
+ *         (the chunks stay within a quarter of the even split), at least two
+ */
+inline size_t batcher_block(size_t const n, int const nw) {
+    size_t block = 2;
+    if (nw == 1) { // Everything is local
+        while (block < n)
+            block *= 2;
+        return block;
+    }
+    while (block * 2 <= n / (4 * static_cast<size_t>(nw)))
+        block *= 2;
+    return block;
+}
+
+/**
+ * @brief The business logic of a Batcher worker: it sorts its blocks alone, through the first stages,
+ *        then it runs its part of every following stage between two barriers.
+ *
+ * @tparam T the element type
+ * @param thid the thread identifier
+ * @param v the pointer to the vector
+ * @param n the number of elements
+ * @param starts the first comparator of every worker (see batcher_starts)
+ * @param block the length of the local blocks (see batcher_block)
+ * @param state the state shared by the threads of the run, with a barrier of the workers only
+ */
+template <typename T>
+void batcher_thread_body(int const thid, T * const v, size_t const n, std::vector<size_t> const &starts,
+                         size_t const block, native_state &state) {
+    auto &sync = *state.sync;
+    auto const from = starts[thid], to = starts[thid + 1];
+
+    METRIC(auto &metrics = state.metrics[thid]; metrics.start();)
+
+    // The comparators of a merge up to the block length stay in a block: no barriers
+    size_t p = 1;
+    for (; 2 * p <= block; p *= 2)
+        for (size_t k = p; k >= 1; k /= 2)
+            batcher_stage(v, n, p, k, from, to);
+    METRIC(metrics.phase_done(0, 0);)
+
+    size_t size = 1;
+    while (size < n)
+        size *= 2;
+    for (; p < size; p *= 2) {
+        for (size_t k = p; k >= 1; k /= 2) {
+            sync.wait(thid); // The previous stage is complete
+            METRIC(metrics.barrier_done();)
+            batcher_stage(v, n, p, k, from, to);
+            METRIC(metrics.phase_done(1, 0);)
+        }
+    }
+    METRIC(metrics.iteration_done();)
+}
+
+#endif // ODD_EVEN_SORT_BATCHER_HPP
@@ -0,0 +1,273 @@
+/**
+ * @file   bench.cpp
+ * @brief  Benchmark driver: it sweeps the array length and the number of workers over the executables,
+ *         and it writes the speedup and efficiency datasets of the report
+ * @author Michele Zoncheddu
+ */
+
+
+#include <algorithm> // std::nth_element, std::minmax_element
+#include <cmath>     // std::fabs
+#include <cstdio>    // popen
+#include <cstdlib>   // strtod
+#include <cstring>   // std::strncmp
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <placement.hpp>
+#include <util.hpp>
+
+/**
+ * The statistics of the repetitions of a configuration, in milliseconds
+ */
+struct sample {
+    double median;
+    double mad; // Median absolute deviation
+    double min;
+    double max;
+};
+
+/**
+ * @brief It splits a comma-separated list of numbers.
+ *
+ * @param list the list
+ * @return the numbers, empty if the list is malformed
+ */
+std::vector<long> parse_list(std::string const &list) {
+    std::vector<long> values;
+    std::stringstream stream{list};
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        char *end;
+        auto const value = strtol(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || value < 1)
+            return {};
+        values.push_back(value);
+    }
+    return values;
+}
+
+/**
+ * @param values the values (reordered)
+ * @return the median of the values
+ */
+double median(std::vector<double> &values) {
+    auto const middle = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), middle, values.end());
+    if (values.size() % 2 != 0)
+        return *middle;
+    return (*middle + *std::max_element(values.begin(), middle)) / 2;
+}
+
+/**
+ * @brief It summarizes the times of the repetitions.
+ *
+ * @param times the times
+ * @return the statistics
+ */
+sample summarize(std::vector<double> times) {
+    auto const bounds = std::minmax_element(times.begin(), times.end());
+    sample result{0, 0, *bounds.first, *bounds.second};
+    result.median = median(times);
+    for (auto &time : times)
+        time = std::fabs(time - result.median);
+    result.mad = median(times);
+    return result;
+}
+
+/**
+ * @brief It runs an executable and reads the time it printed.
+ *
+ * @param command the command line
+ * @param ms the time of the sort, in milliseconds
+ * @return false if the executable failed or didn't print the time
+ */
+bool run_once(std::string const &command, double &ms) {
+    auto const pipe = popen((command + " 2>&1").c_str(), "r");
+    if (pipe == nullptr)
+        return false;
+
+    bool found = false;
+    char line[256];
+    while (fgets(line, sizeof(line), pipe) != nullptr) {
+        if (std::strncmp(line, "Time: ", 6) == 0) {
+            ms = strtod(line + 6, nullptr);
+            found = true;
+        }
+    }
+    return pclose(pipe) == 0 && found;
+}
+
+/**
+ * @brief It measures a configuration: the warm-up runs are discarded.
+ *
+ * @param command the command line
+ * @param warmup the number of warm-up runs
+ * @param repetitions the number of measured runs
+ * @param result the statistics of the measured runs
+ * @return false if a run failed
+ */
+bool measure(std::string const &command, long warmup, long repetitions, sample &result) {
+    double ms;
+    for (long i = 0; i < warmup; ++i)
+        if (!run_once(command, ms))
+            return false;
+
+    std::vector<double> times;
+    for (long i = 0; i < repetitions; ++i) {
+        if (!run_once(command, ms))
+            return false;
+        times.push_back(ms);
+    }
+    result = summarize(times);
+    return true;
+}
+
+/**
+ * @brief It writes a dataset in the format of doc/data: one row per number of workers, one column per size.
+ *
+ * @param path the file path
+ * @param sizes the sizes, in thousands of elements
+ * @param workers the numbers of workers
+ * @param value the value of a cell, from the number of workers and the size
+ * @param ideal the ideal value, from the number of workers
+ * @return false if the file can't be written
+ */
+template <typename Value, typename Ideal>
+bool write_dat(std::string const &path, std::vector<long> const &sizes, std::vector<long> const &workers,
+               Value value, Ideal ideal) {
+    std::ofstream file{path};
+    file << "x ideal";
+    for (auto size : sizes)
+        file << ' ' << size;
+    file << '\n';
+    for (auto nw : workers) {
+        file << nw << ' ' << ideal(nw);
+        for (auto size : sizes)
+            file << ' ' << std::round(value(nw, size) * 100) / 100;
+        file << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+/**
+ * @brief the starting method
+ *
+ * @return the exit status
+ */
+int main(int argc, char const *argv[]) {
+    auto const options = parse_options(argc, argv);
+    if (argc > 1) {
+        std::cout << "Usage is " << argv[0]
+                  << " [--engines=par,batcher,ff] [--sizes=thousands,...] [--workers=nw,...] [--warmup=runs]"
+                  << " [--repetitions=runs] [--seed=seed] [--output=directory] [--args=\"options\"]"
+                  << " [--distribution=name]" << std::endl;
+        return -1;
+    }
+
+    // Default: 1, then the even numbers of workers, up to one CPU less than the usable ones (for the controller)
+    long const hw_concurrency = std::max(2, effective_cpus());
+    std::string default_workers = "1";
+    for (long nw = 2; nw < hw_concurrency; nw += 2)
+        default_workers += ',' + std::to_string(nw);
+    if (hw_concurrency > 2 && (hw_concurrency - 1) % 2 != 0)
+        default_workers += ',' + std::to_string(hw_concurrency - 1);
+
+    auto const sizes       = parse_list(get_option(options, "sizes", "100,200,300,400,500,600"));
+    auto const workers     = parse_list(get_option(options, "workers", default_workers));
+    auto const warmup      = strtol(get_option(options, "warmup", "1").c_str(), nullptr, 10);
+    auto const repetitions = strtol(get_option(options, "repetitions", "5").c_str(), nullptr, 10);
+    auto const seed        = get_option(options, "seed", "1");
+    auto const output      = get_option(options, "output", "../doc/data");
+    auto const args        = get_option(options, "args", "") + " --distribution="
+                             + get_option(options, "distribution", "uniform");
+    auto const engines     = get_option(options, "engines", "par,batcher,ff");
+
+    if (sizes.empty() || workers.empty() || warmup < 0 || repetitions < 1) {
+        std::cout << "sizes and workers must be lists of positive numbers, and repetitions at least one" << std::endl;
+        return -1;
+    }
+
+    // The executables are next to the driver
+    std::string directory{argv[0]};
+    directory = directory.find('/') == std::string::npos ? "." : directory.substr(0, directory.rfind('/'));
+
+    std::ofstream times{output + "/times.dat"};
+    if (!times) {
+        std::cout << "Error writing the datasets in " << output << std::endl;
+        return -1;
+    }
+    times << "engine size nw median mad min max\n";
+
+    // The sequential baseline
+    std::map<long, double> baseline;
+    for (auto size : sizes) {
+        sample result;
+        auto const command = directory + "/seq " + std::to_string(size * 1000) + ' ' + seed + ' ' + args;
+        if (!measure(command, warmup, repetitions, result)) {
+            std::cout << "Error running " << command << std::endl;
+            return -1;
+        }
+        baseline[size] = result.median;
+        times << "seq " << size << " 1 " << result.median << ' ' << result.mad << ' ' << result.min << ' '
+              << result.max << '\n';
+        std::cout << "seq n=" << size << "K: " << result.median << " ms (mad " << result.mad << ")" << std::endl;
+    }
+
+    // The parallel engines: their executable with its options, and the names of their datasets
+    struct parallel_engine {
+        std::string command;
+        std::string dataset;
+    };
+    std::map<std::string, parallel_engine> const datasets{{"par", {"par", "native"}},
+                                                          {"batcher", {"par --engine=batcher", "batcher"}},
+                                                          {"processes", {"par --processes", "processes"}},
+                                                          {"ff", {"ff", "ff"}}};
+    std::stringstream stream{engines};
+    std::string engine;
+    while (std::getline(stream, engine, ',')) {
+        if (datasets.count(engine) == 0) {
+            std::cout << "Unknown engine " << engine << std::endl;
+            return -1;
+        }
+
+        std::map<long, std::map<long, double>> medians; // nw -> size -> median
+        bool failed = false;
+        for (auto nw : workers) {
+            for (auto size : sizes) {
+                sample result;
+                auto const command = directory + '/' + datasets.at(engine).command + ' ' + std::to_string(size * 1000)
+                                     + ' ' + std::to_string(nw) + ' ' + seed + ' ' + args;
+                if (!measure(command, warmup, repetitions, result)) {
+                    std::cout << "Error running " << command << ", skipping " << engine << std::endl;
+                    failed = true;
+                    break;
+                }
+                medians[nw][size] = result.median;
+                times << engine << ' ' << size << ' ' << nw << ' ' << result.median << ' ' << result.mad << ' '
+                      << result.min << ' ' << result.max << '\n';
+                std::cout << engine << " n=" << size << "K nw=" << nw << ": " << result.median << " ms (mad "
+                          << result.mad << ")" << std::endl;
+            }
+            if (failed)
+                break;
+        }
+        if (failed)
+            continue;
+
+        auto const speedup = [&](long nw, long size) { return baseline[size] / medians[nw][size]; };
+        auto const name = datasets.at(engine).dataset;
+        if (!write_dat(output + "/speedup_" + name + ".dat", sizes, workers, speedup, [](long nw) { return nw; })
+            || !write_dat(output + "/efficiency_" + name + ".dat", sizes, workers,
+                          [&](long nw, long size) { return speedup(nw, size) / nw; }, [](long) { return 1; })) {
+            std::cout << "Error writing the datasets in " << output << std::endl;
+            return -1;
+        }
+    }
+
+    return 0;
+}
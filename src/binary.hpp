@@ -0,0 +1,221 @@
+/**
+ * @file   binary.hpp
+ * @brief  It contains the binary array files: raw little-endian elements, optionally after a header
+ *         with their type and length. The inputs are mapped and sorted in place.
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_BINARY_HPP
+#define ODD_EVEN_SORT_BINARY_HPP
+
+#include <algorithm> // std::min
+#include <cerrno>
+#include <cstdint>
+#include <cstring>   // strerror, memcmp, strnlen
+#include <map>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <config.hpp>
+#include <mapping.hpp>
+#include <util.hpp>
+
+/**
+ * The optional header of a binary file: the elements follow it, aligned for every type
+ */
+struct binary_header {
+    char magic[8];   // binary_magic
+    char type[8];    // The element type name (see element_types), padded with zeros
+    uint64_t length; // The number of elements
+};
+
+char constexpr binary_magic[8] = {'O', 'D', 'D', 'E', 'V', 'E', 'N', '\0'};
+
+// The length of a write: large enough to be sequential on the device
+size_t constexpr binary_write_chunk = 64 << 20;
+
+/**
+ * @return the size of an element type, zero if the name is unknown
+ */
+inline size_t element_size(std::string const &type) {
+    size_t size = 0;
+    dispatch_type(type, [&](auto element) { size = sizeof(element); });
+    return size;
+}
+
+/**
+ * A binary file mapped as an array, to be sorted in place: with a private mapping the file is untouched,
+ * with a shared one the file is sorted
+ */
+class binary_input {
+public:
+    /**
+     * @brief It maps a binary file, reading its header if it has one.
+     *
+     * @param path the file
+     * @param shared if true, the sort goes to the file
+     * @param type the element type of a raw file (empty: int32); a header must agree with it
+     * @return the error message, empty if the file is mapped
+     */
+    std::string open(std::string const &path, bool const shared, std::string const &type) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        return "the binary files are little-endian";
+#endif
+        auto const error = file.open(path, shared, true); // Read now: the page faults are not timed
+        if (!error.empty())
+            return error;
+
+        name = type.empty() ? "int32" : type;
+        offset = 0;
+        binary_header head{};
+        if (file.size() >= sizeof(head)) {
+            std::copy_n(static_cast<char const *>(file.data()), sizeof(head), reinterpret_cast<char *>(&head));
+            if (memcmp(head.magic, binary_magic, sizeof(binary_magic)) == 0) {
+                std::string const stored{head.type, strnlen(head.type, sizeof(head.type))};
+                if (!type.empty() && type != stored)
+                    return path + " holds " + stored + " elements, not " + type;
+                name = stored;
+                offset = sizeof(head);
+            }
+        }
+
+        auto const size = element_size(name);
+        if (size == 0)
+            return "Unknown type " + name;
+        length = (file.size() - offset) / size;
+        if ((file.size() - offset) % size != 0 || (offset > 0 && head.length != length))
+            return path + " doesn't hold whole " + name + " elements";
+        if (length == 0)
+            return path + " has no elements";
+        return "";
+    }
+
+    /**
+     * @return the element type name
+     */
+    std::string const &type() const {
+        return name;
+    }
+
+    /**
+     * @return the number of elements
+     */
+    size_t size() const {
+        return length;
+    }
+
+    /**
+     * @return true if the file has a header
+     */
+    bool has_header() const {
+        return offset > 0;
+    }
+
+    /**
+     * @return true if a file is mapped
+     */
+    bool is_open() const {
+        return length > 0;
+    }
+
+    /**
+     * @tparam T the element type, the one of the file
+     * @return the first element
+     */
+    template <typename T>
+    T *data() const {
+        return reinterpret_cast<T *>(static_cast<char *>(file.data()) + offset);
+    }
+
+private:
+    mapped_file file;
+    std::string name;
+    size_t offset = 0;
+    size_t length = 0;
+};
+
+/**
+ * @brief It writes an array in a binary file, with large sequential writes.
+ *
+ * @tparam T the element type
+ * @param path the file, created or truncated
+ * @param v the pointer to the array
+ * @param n the number of elements
+ * @param type the element type name, for the header
+ * @param header if true, the header is written before the elements
+ * @return the error message, empty if the array is written
+ */
+template <typename T>
+std::string write_binary(std::string const &path, T const * const v, size_t const n, std::string const &type,
+                         bool const header) {
+    auto const fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return path + ": " + strerror(errno);
+
+    auto const write_all = [&](char const *bytes, size_t left) {
+        while (left > 0) {
+            auto const written = ::write(fd, bytes, std::min(left, binary_write_chunk));
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return false;
+            bytes += written;
+            left -= static_cast<size_t>(written);
+        }
+        return true;
+    };
+
+    binary_header head{};
+    std::copy_n(binary_magic, sizeof(binary_magic), head.magic);
+    type.copy(head.type, sizeof(head.type)); // Zero-padded, without a terminator if it fills the field
+    head.length = n;
+    auto const written = (!header || write_all(reinterpret_cast<char const *>(&head), sizeof(head)))
+                         && write_all(reinterpret_cast<char const *>(v), n * sizeof(T));
+    auto const closed = close(fd) == 0;
+    return written && closed ? "" : path + ": " + strerror(errno);
+}
+
+/**
+ * The binary files of a run, from the options: the input (not open: a random array) and the output (empty: none)
+ */
+struct binary_files {
+    binary_input input;
+    std::string type;    // The element type: the one of the input, or --type
+    std::string output;
+    bool header = false; // Of the output: with --header, or like the input
+};
+
+/**
+ * @brief It opens the binary files of the options: --input=file, --map=private|shared, --output=file, --header.
+ *
+ * @param options the options map
+ * @param n the array length of the command line, set to the one of the input if zero
+ * @param files the files
+ * @return the error message, empty if the files are ready
+ */
+inline std::string open_binary_files(std::map<std::string, std::string> const &options, long &n,
+                                     binary_files &files) {
+    auto const input = get_option(options, "input", "");
+    auto const mapping = get_option(options, "map", "private");
+    if (mapping != "private" && mapping != "shared")
+        return "Unknown mapping " + mapping;
+    files.type = get_option(options, "type", "int32");
+    if (!input.empty()) {
+        auto const error = files.input.open(input, mapping == "shared", get_option(options, "type", ""));
+        if (!error.empty())
+            return error;
+        if (n == 0)
+            n = static_cast<long>(files.input.size());
+        if (static_cast<size_t>(n) != files.input.size())
+            return "n must be 0 or the length of " + input + " (" + std::to_string(files.input.size()) + ")";
+        files.type = files.input.type();
+    }
+    files.output = get_option(options, "output", "");
+    files.header = options.count("header") > 0 || files.input.has_header();
+    return "";
+}
+
+#endif // ODD_EVEN_SORT_BINARY_HPP
@@ -0,0 +1,253 @@
+/**
+ * @file   columns.hpp
+ * @brief  It contains the key-value sorting of tables stored by columns (structure of arrays)
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_COLUMNS_HPP
+#define ODD_EVEN_SORT_COLUMNS_HPP
+
+#include <algorithm> // std::min, std::swap_ranges
+#include <cstddef>
+#include <cstdint>
+#include <cstring>   // std::memcpy
+#include <numeric>   // std::iota
+#include <vector>
+
+#include <distributions.hpp>
+#include <util.hpp>
+
+// Maximum number of key and payload columns of a view
+size_t constexpr max_key_columns     = 8;
+size_t constexpr max_payload_columns = 16;
+
+// Pairs whose exchanges are decided on the keys before moving the payloads
+size_t constexpr exchange_segment = 256;
+
+/**
+ * A payload column: it's only moved, so it's described by its element width
+ */
+struct payload_column {
+    char *data;
+    size_t width;
+};
+
+/**
+ * The view of a table stored by columns: the rows are ordered by the key columns (lexicographically),
+ * and the payload columns follow the same exchanges of the keys.
+ * It's used by the kernels as a vector pointer: v + offset is the view starting from the row offset.
+ *
+ * @tparam K the key type
+ */
+template <typename K>
+struct column_view {
+    K *keys[max_key_columns];
+    payload_column payloads[max_payload_columns];
+    size_t key_count     = 0;
+    size_t payload_count = 0;
+
+    /**
+     * @brief It adds a key column, less significant than the previous ones.
+     *
+     * @param column the pointer to the column
+     */
+    void add_key(K * const column) {
+        keys[key_count++] = column;
+    }
+
+    /**
+     * @brief It adds a payload column.
+     *
+     * @tparam P the payload type
+     * @param column the pointer to the column
+     */
+    template <typename P>
+    void add_payload(P * const column) {
+        payloads[payload_count++] = payload_column{reinterpret_cast<char *>(column), sizeof(P)};
+    }
+
+    /**
+     * @param offset the first row of the new view
+     * @return the view starting from the row offset
+     */
+    column_view operator+(size_t const offset) const {
+        column_view shifted = *this;
+        for (size_t c = 0; c < key_count; ++c)
+            shifted.keys[c] += offset;
+        for (size_t c = 0; c < payload_count; ++c)
+            shifted.payloads[c].data += offset * payloads[c].width;
+        return shifted;
+    }
+};
+
+/**
+ * @brief The bytes of a row, to size the tiles.
+ *
+ * @tparam K the key type
+ * @param v the view
+ * @return the size of the row
+ */
+template <typename K>
+size_t row_bytes(column_view<K> const &v) {
+    auto bytes = v.key_count * sizeof(K);
+    for (size_t c = 0; c < v.payload_count; ++c)
+        bytes += v.payloads[c].width;
+    return bytes;
+}
+
+/**
+ * @brief It applies the exchanges to the pairs of a column.
+ *
+ * @tparam U the column type
+ * @param column the pointer to the first pair
+ * @param exchange the exchanges, one per pair
+ * @param pairs the number of pairs
+ */
+template <typename U>
+void exchange_pairs(U * const column, unsigned char const * const exchange, size_t const pairs) {
+    for (size_t p = 0; p < pairs; ++p) {
+        auto first = column[2 * p], second = column[2 * p + 1];
+        column[2 * p]     = exchange[p] ? second : first;
+        column[2 * p + 1] = exchange[p] ? first : second;
+    }
+}
+
+/**
+ * @brief It applies the exchanges to the pairs of a payload column.
+ *
+ * @param column the payload column, starting from the first pair
+ * @param exchange the exchanges, one per pair
+ * @param pairs the number of pairs
+ */
+inline void exchange_pairs(payload_column const &column, unsigned char const * const exchange, size_t const pairs) {
+    switch (column.width) {
+        case 1: exchange_pairs(reinterpret_cast<uint8_t *>(column.data), exchange, pairs); break;
+        case 2: exchange_pairs(reinterpret_cast<uint16_t *>(column.data), exchange, pairs); break;
+        case 4: exchange_pairs(reinterpret_cast<uint32_t *>(column.data), exchange, pairs); break;
+        case 8: exchange_pairs(reinterpret_cast<uint64_t *>(column.data), exchange, pairs); break;
+        default:
+            for (size_t p = 0; p < pairs; ++p) {
+                if (exchange[p]) {
+                    auto const first = column.data + 2 * p * column.width;
+                    std::swap_ranges(first, first + column.width, first + column.width);
+                }
+            }
+    }
+}
+
+/**
+ * @brief It performs an odd or an even sorting phase on a table.
+ *        The exchanges of a segment of pairs are first decided on the keys only, then they are applied
+ *        column by column, so every loop works on a single dense column.
+ *
+ * @tparam K the key type
+ * @param v the view of the table
+ * @param phase the phase (odd or even)
+ * @param end the end of the table
+ * @return non-zero if at least one swap has been performed
+ */
+template <typename K>
+unsigned odd_even_sort(column_view<K> const &v, short const phase, size_t const end) {
+    unsigned char exchange[exchange_segment];
+    unsigned swaps = 0;
+
+    for (size_t start = phase; start < end; start += 2 * exchange_segment) {
+        auto const pairs = std::min(exchange_segment, (end - start + 1) / 2);
+
+        // Lexicographic comparison: a pair is exchanged on the first different key
+        unsigned char any = 0;
+        for (size_t p = 0; p < pairs; ++p) {
+            bool greater = false, equal = true;
+            for (size_t c = 0; c < v.key_count; ++c) {
+                auto const first = v.keys[c][start + 2 * p], second = v.keys[c][start + 2 * p + 1];
+                greater |= equal && first > second;
+                equal   &= first == second;
+            }
+            exchange[p] = greater;
+            any |= exchange[p];
+        }
+        if (!any)
+            continue;
+
+        swaps = 1;
+        for (size_t c = 0; c < v.key_count; ++c)
+            exchange_pairs(v.keys[c] + start, exchange, pairs);
+        for (size_t c = 0; c < v.payload_count; ++c)
+            exchange_pairs(payload_column{v.payloads[c].data + start * v.payloads[c].width, v.payloads[c].width},
+                           exchange, pairs);
+    }
+    return swaps;
+}
+
+/**
+ * A table stored by columns, with random keys and the original row in every payload column,
+ * to check that the payloads followed their keys.
+ *
+ * @tparam K the key type
+ */
+template <typename K>
+struct random_table {
+    std::vector<std::vector<K>> keys;
+    std::vector<std::vector<K>> original_keys;
+    std::vector<std::vector<uint32_t>> payloads;
+
+    /**
+     * @brief It creates the table.
+     *
+     * @param n the number of rows
+     * @param key_count the number of key columns (the most significant one with few distinct values,
+     *                  so the next keys break the ties)
+     * @param payload_count the number of payload columns
+     * @param min the lower bound for the keys
+     * @param max the upper bound for the keys
+     * @param seed the seed for the random generator
+     * @param d the distribution of every key column
+     */
+    random_table(size_t n, size_t key_count, size_t payload_count, K min, K max, unsigned seed,
+                 distribution const &d = distribution{}) {
+        for (size_t c = 0; c < key_count; ++c) {
+            auto const upper = c == 0 && key_count > 1 ? static_cast<K>(min + 16) : max;
+            keys.push_back(create_vector<K>(d, n, min, upper, seed + c));
+        }
+        original_keys = keys;
+        payloads.assign(payload_count, std::vector<uint32_t>(n));
+        for (auto &column : payloads)
+            std::iota(column.begin(), column.end(), 0);
+    }
+
+    /**
+     * @return the view of the whole table
+     */
+    column_view<K> view() {
+        column_view<K> v;
+        for (auto &column : keys)
+            v.add_key(column.data());
+        for (auto &column : payloads)
+            v.add_payload(column.data());
+        return v;
+    }
+
+    /**
+     * @return true if the rows are sorted and every payload still belongs to its keys
+     */
+    bool is_sorted() const {
+        auto const n = keys.empty() ? 0 : keys[0].size();
+        for (size_t i = 0; i + 1 < n; ++i) {
+            for (size_t c = 0; c < keys.size(); ++c) {
+                if (keys[c][i] < keys[c][i + 1])
+                    break;
+                if (keys[c][i] > keys[c][i + 1])
+                    return false;
+            }
+        }
+        for (auto const &column : payloads)
+            for (size_t i = 0; i < n; ++i)
+                for (size_t c = 0; c < keys.size(); ++c)
+                    if (keys[c][i] != original_keys[c][column[i]])
+                        return false;
+        return true;
+    }
+};
+
+#endif // ODD_EVEN_SORT_COLUMNS_HPP
@@ -1,12 +1,56 @@
 /**
  * @file   config.hpp
- * @brief  It defines the array type and bounds
+ * @brief  It defines the array types and bounds
  * @author Michele Zoncheddu
  */
 
 
-using vec_type = int;
+#ifndef ODD_EVEN_SORT_CONFIG_HPP
+#define ODD_EVEN_SORT_CONFIG_HPP
 
-// Upper and lower bounds for array elements
-#define MIN 0
-#define MAX INT32_MAX
+#include <cstdint>
+#include <limits>
+#include <string>
+
+/**
+ * Upper and lower bounds for the array elements: non-negative, at most INT32_MAX for the floating point types
+ *
+ * @tparam T the element type
+ */
+template <typename T>
+struct element_traits {
+    static T min() { return 0; }
+
+    static T max() {
+        return std::numeric_limits<T>::is_integer ? std::numeric_limits<T>::max() : static_cast<T>(INT32_MAX);
+    }
+};
+
+// The element type names accepted by --type
+char constexpr element_types[] = "int8|uint8|int16|uint16|int32|uint32|int64|uint64|float|double";
+
+/**
+ * @brief It calls f with a value of the element type selected by name, to instantiate the sorting for it.
+ *
+ * @tparam F the callable type, taking any element type
+ * @param name the element type name (see element_types)
+ * @param f the callable
+ * @return false if the name is unknown
+ */
+template <typename F>
+bool dispatch_type(std::string const &name, F &&f) {
+    if      (name == "int8")   f(int8_t{});
+    else if (name == "uint8")  f(uint8_t{});
+    else if (name == "int16")  f(int16_t{});
+    else if (name == "uint16") f(uint16_t{});
+    else if (name == "int32")  f(int32_t{});
+    else if (name == "uint32") f(uint32_t{});
+    else if (name == "int64")  f(int64_t{});
+    else if (name == "uint64") f(uint64_t{});
+    else if (name == "float")  f(float{});
+    else if (name == "double") f(double{});
+    else return false;
+    return true;
+}
+
+#endif // ODD_EVEN_SORT_CONFIG_HPP
@@ -0,0 +1,172 @@
+/**
+ * @file   distributions.hpp
+ * @brief  It contains the input generators, from uniform data to the presorted and skewed ones
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_DISTRIBUTIONS_HPP
+#define ODD_EVEN_SORT_DISTRIBUTIONS_HPP
+
+#include <algorithm>  // std::sort, std::shuffle, std::upper_bound
+#include <cmath>      // std::pow
+#include <cstdlib>    // strtod
+#include <functional> // std::greater
+#include <random>
+#include <string>
+#include <vector>
+
+#include <util.hpp>
+
+// The distribution names accepted by --distribution, with their optional parameter
+char constexpr distribution_names[] =
+        "uniform|sorted|reverse|nearly-sorted[:d]|few-unique[:k]|organ-pipe|sawtooth[:period]|zipf[:s]|runs[:r]";
+
+/**
+ * The shape of the input
+ */
+enum class shape {
+    uniform,       // Independent uniform values
+    sorted,        // Ascending: one iteration to sort
+    reverse,       // Descending: n phases to sort
+    nearly_sorted, // Ascending, shuffled in windows of parameter + 1 elements: nobody is more than parameter away
+    few_unique,    // Uniform among parameter distinct values
+    organ_pipe,    // Ascending, then descending
+    sawtooth,      // Ascending ramps of parameter elements
+    zipf,          // Distinct values drawn with probability proportional to 1 / rank^parameter
+    runs           // Parameter ascending runs of random values
+};
+
+/**
+ * A distribution: the shape and its parameter
+ */
+struct distribution {
+    shape kind       = shape::uniform;
+    double parameter = 0;
+};
+
+/**
+ * @brief It parses a distribution, "name" or "name:parameter" (see distribution_names).
+ *
+ * @param spec the distribution
+ * @param result the parsed distribution, with the default parameter if it's missing
+ * @return false if the name is unknown or the parameter is not positive
+ */
+inline bool parse_distribution(std::string const &spec, distribution &result) {
+    auto const colon = spec.find(':');
+    auto const name  = spec.substr(0, colon);
+
+    struct entry {
+        char const *name;
+        shape kind;
+        double parameter; // The default, zero if the shape has no parameter
+    };
+    entry const entries[] = {
+            {"uniform", shape::uniform, 0},
+            {"sorted", shape::sorted, 0},
+            {"reverse", shape::reverse, 0},
+            {"nearly-sorted", shape::nearly_sorted, 16},
+            {"few-unique", shape::few_unique, 16},
+            {"organ-pipe", shape::organ_pipe, 0},
+            {"sawtooth", shape::sawtooth, 1024},
+            {"zipf", shape::zipf, 1},
+            {"runs", shape::runs, 16}
+    };
+
+    for (auto const &elem : entries) {
+        if (name != elem.name)
+            continue;
+        result = distribution{elem.kind, elem.parameter};
+        if (colon == std::string::npos)
+            return true;
+        if (elem.parameter == 0)
+            return false; // No parameter for this shape
+        char *end;
+        result.parameter = strtod(spec.c_str() + colon + 1, &end);
+        return *end == '\0' && result.parameter > 0;
+    }
+    return false;
+}
+
+/**
+ * @brief Generates a vector with the given distribution.
+ *
+ * @tparam T the vector type
+ * @param d the distribution
+ * @param n the number of element to put into the vector
+ * @param min the lower bound for the values
+ * @param max the upper bound for the values
+ * @param seed the seed for the random generator
+ * @return the vector
+ */
+template <typename T>
+std::vector<T> create_vector(distribution const &d, size_t n, T min, T max, unsigned seed) {
+    auto const parameter = static_cast<size_t>(std::max(1.0, d.parameter));
+    std::mt19937 gen{seed + 1}; // Not the one of the values
+
+    std::vector<T> v;
+    switch (d.kind) {
+        case shape::uniform:
+            return create_random_vector<T>(n, min, max, seed);
+
+        case shape::sorted:
+        case shape::nearly_sorted:
+            v = create_random_vector<T>(n, min, max, seed);
+            std::sort(v.begin(), v.end());
+            if (d.kind == shape::nearly_sorted)
+                for (size_t first = 0; first < n; first += parameter + 1)
+                    std::shuffle(v.begin() + first, v.begin() + std::min(n, first + parameter + 1), gen);
+            return v;
+
+        case shape::reverse:
+            v = create_random_vector<T>(n, min, max, seed);
+            std::sort(v.begin(), v.end(), std::greater<T>());
+            return v;
+
+        case shape::few_unique: {
+            auto const values = create_random_vector<T>(parameter, min, max, seed);
+            std::uniform_int_distribution<size_t> pick(0, values.size() - 1);
+            v.resize(n);
+            for (auto &elem : v)
+                elem = values[pick(gen)];
+            return v;
+        }
+
+        case shape::organ_pipe:
+            v = create_random_vector<T>(n, min, max, seed);
+            std::sort(v.begin(), v.begin() + n / 2);
+            std::sort(v.begin() + n / 2, v.end(), std::greater<T>());
+            return v;
+
+        case shape::sawtooth:
+        case shape::runs: {
+            v = create_random_vector<T>(n, min, max, seed);
+            auto const run = d.kind == shape::sawtooth ? parameter
+                                                       : std::max<size_t>(1, (n + parameter - 1) / parameter);
+            for (size_t first = 0; first < n; first += run)
+                std::sort(v.begin() + first, v.begin() + std::min(n, first + run));
+            return v;
+        }
+
+        case shape::zipf: {
+            // Inverse transform sampling on the cumulative weights of the ranks
+            auto const distinct = std::min<size_t>(std::max<size_t>(n, 1), 1 << 16);
+            auto const values   = create_random_vector<T>(distinct, min, max, seed);
+            std::vector<double> cumulative(values.size());
+            double sum = 0;
+            for (size_t rank = 0; rank < values.size(); ++rank)
+                cumulative[rank] = sum += 1 / std::pow(rank + 1, d.parameter);
+            std::uniform_real_distribution<> pick(0, sum);
+            v.resize(n);
+            for (auto &elem : v) {
+                size_t const rank = std::upper_bound(cumulative.begin(), cumulative.end(), pick(gen))
+                                    - cumulative.begin();
+                elem = values[std::min(rank, values.size() - 1)];
+            }
+            return v;
+        }
+    }
+    return v;
+}
+
+#endif // ODD_EVEN_SORT_DISTRIBUTIONS_HPP
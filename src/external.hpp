@@ -0,0 +1,125 @@
+/**
+ * @file   external.hpp
+ * @brief  It contains the out-of-core sort: the blocks of a mapped file are sorted in memory,
+ *         then merge-split by the odd-even phases between adjacent blocks
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_EXTERNAL_HPP
+#define ODD_EVEN_SORT_EXTERNAL_HPP
+
+#include <algorithm> // std::copy, std::min
+#include <cstddef>
+#include <cstdint>
+#include <memory>    // Smart pointers
+#include <vector>
+
+#include <mapping.hpp>
+#include <native.hpp>
+#include <oddeven.hpp>
+#include <pool.hpp>
+
+/**
+ * What the out-of-core sort did so far
+ */
+struct external_progress {
+    size_t blocks   = 0; // The blocks of the file
+    size_t sorted   = 0; // The blocks sorted in memory
+    size_t passes   = 0; // The merge-split passes, an odd and an even phase each
+    size_t changed  = 0; // The boundaries changed by the last pass
+    uint64_t read    = 0; // The bytes read through the mapping
+    uint64_t written = 0; // The bytes written through the mapping
+};
+
+namespace oddeven {
+
+/**
+ * @brief It sorts a mapped file of elements in place, a block in memory at a time.
+ *        Every block is sorted by the native workers (the same threads for all the blocks, with the
+ *        transposition engine, quadratic in the block: the block engine suits the large ones), while the next one
+ *        is read ahead. Then the odd-even phases run on the blocks: two adjacent blocks out of order at their
+ *        boundary are merged, and split back, the lower part on the left. The phases stop after two phases in a row
+ *        without boundary changes. The written blocks are sent back to the file at once, and the next pair is read
+ *        ahead during a merge.
+ *
+ * @tparam T the element type
+ * @tparam Report the progress callback type
+ * @param file the file, mapped
+ * @param block the elements of a block: two blocks and their merge buffers (four blocks) must fit in memory
+ * @param p the policy of the in-memory sorts, that must be valid (see validate)
+ * @param report it takes the progress after every block sorted and every pass
+ * @return the final progress
+ */
+template <typename T, typename Report>
+external_progress sort_external(mapped_file const &file, size_t const block, policy const &p, Report report) {
+    auto const first = static_cast<T *>(file.data());
+    size_t const n = file.size() / sizeof(T);
+    external_progress progress;
+    progress.blocks = (n + block - 1) / block;
+
+    auto const begin  = [&](size_t b) { return first + b * block; };
+    auto const length = [&](size_t b) { return b < progress.blocks ? std::min(block, n - b * block) : 0; };
+
+    // The in-memory stage: the sorter keeps its threads, the other engines create them for every block
+    std::unique_ptr<sorter<T>> workers;
+    if (p.engine == engine::transposition && p.metrics == nullptr)
+        workers = std::make_unique<sorter<T>>(p);
+    file.read_ahead(begin(0), length(0) * sizeof(T));
+    for (size_t b = 0; b < progress.blocks; ++b) {
+        file.read_ahead(begin(b + 1), length(b + 1) * sizeof(T));
+        if (workers) {
+            workers->submit(begin(b), begin(b) + length(b));
+            workers->wait();
+        } else {
+            sort(begin(b), begin(b) + length(b), p);
+        }
+        file.write_back(begin(b), length(b) * sizeof(T));
+        ++progress.sorted;
+        progress.read    += length(b) * sizeof(T);
+        progress.written += length(b) * sizeof(T);
+        report(progress);
+    }
+    workers.reset();
+
+    // The merge-split phases, until an odd and an even phase in a row without changes
+    std::vector<T> low(block), high(block);
+    size_t changed = 0, phase = 0;
+    auto const pass_done = [&] {
+        ++progress.passes;
+        progress.changed = changed;
+        changed = 0;
+        report(progress);
+    };
+    for (size_t calm = 0; progress.blocks > 1 && calm < 2; ++phase) {
+        size_t phase_changed = 0;
+        for (size_t b = phase % 2; b + 1 < progress.blocks; b += 2) {
+            auto const left = begin(b), right = begin(b + 1);
+            auto const left_len = length(b), right_len = length(b + 1);
+            progress.read += 2 * sizeof(T);
+            if (!(right[0] < left[left_len - 1])) // Already split
+                continue;
+
+            file.read_ahead(begin(b + 2), (length(b + 2) + length(b + 3)) * sizeof(T)); // The next pair
+            merge_split<T>(left, left_len, right, right_len, low.data(), true);
+            merge_split<T>(left, left_len, right, right_len, high.data(), false);
+            std::copy(low.begin(), low.begin() + left_len, left);
+            std::copy(high.begin(), high.begin() + right_len, right);
+            file.write_back(left, (left_len + right_len) * sizeof(T));
+            progress.read    += (left_len + right_len) * sizeof(T);
+            progress.written += (left_len + right_len) * sizeof(T);
+            ++phase_changed;
+        }
+        calm = phase_changed > 0 ? 0 : calm + 1;
+        changed += phase_changed;
+        if (phase % 2 == 1)
+            pass_done();
+    }
+    if (phase % 2 == 1) // The last pass stopped after its first phase
+        pass_done();
+    return progress;
+}
+
+} // namespace oddeven
+
+#endif // ODD_EVEN_SORT_EXTERNAL_HPP
@@ -5,13 +5,22 @@
  */
 
 
-#include <algorithm> // std::is_sorted
+#include <algorithm> // std::is_sorted, std::fill
 #include <cassert>
+#include <chrono>
 #include <iostream>
+#include <cstdint>
 #include <memory>    // Smart pointers
 #include <vector>
 
+#include <balance.hpp>
+#include <binary.hpp>
+#include <columns.hpp>
 #include <config.hpp>
+#include <distributions.hpp>
+#include <kernel.hpp>
+#include <metrics.hpp>
+#include <placement.hpp>
 #include <util.hpp>
 
 #include <ff/ff.hpp>
@@ -19,28 +28,8 @@
 
 using namespace ff;
 
-/**
- * @brief It performs an odd or an even sorting phase on the array
- *
- * @tparam T the vector pointer type
- * @param v the pointer to the vector
- * @param phase the phase (odd or even)
- * @param end the end of the array
- * @return the number of swaps
- */
-template <typename T>
-unsigned odd_even_sort(T * const v, short const phase, size_t const end) {
-    unsigned swaps = 0;
-    for (size_t i = phase; i < end; i += 2) {
-        auto first = v[i], second = v[i + 1];
-        auto cond = first > second;
-        v[i]     = cond ? second : first;
-        v[i + 1] = cond ? first : second;
-        if (v[i] != first)
-            swaps++;
-    }
-    return swaps;
-}
+// The distance between the busy times of two workers: a cache line
+size_t constexpr busy_stride = 64 / sizeof(uint64_t);
 
 /**
  * The emitter structure
@@ -67,14 +56,24 @@ struct Emitter : ff_monode_t<unsigned> {
         static unsigned dummy_task = 0;
         static bool previous_zero = false; // I need to stop after two consecutive phases with no swaps
 
+        METRIC(metrics->spin_done();) // Waiting for the feedback
+
         // task always from feedback
         if (!swaps)
             swaps = *task;
 
         if (--remaining == 0) {
-            if (previous_zero && !swaps) // Zero swaps also in the previous phase, stop
+            if (previous_zero && !swaps) { // Zero swaps also in the previous phase, stop
+                METRIC(metrics->iteration_done();)
                 return EOS;
+            }
+            // Every worker is waiting for me: I can move the boundaries
+            if (period > 0 && ++phase_count % (2 * period) == 0) {
+                rebalance(*starts, busy->data(), busy_stride);
+                std::fill(busy->begin(), busy->end(), 0);
+            }
             broadcast_task(&dummy_task);
+            METRIC(metrics->phase_done(phases % 2, swaps); if (++phases % 2 == 0) metrics->iteration_done();)
             previous_zero = swaps == 0;
             swaps = 0;
             remaining = nw;
@@ -82,22 +81,45 @@ struct Emitter : ff_monode_t<unsigned> {
         return GO_ON;
     }
 
+    int svc_init() override {
+        ff_mapThreadToCpu(static_cast<int>(cpu)); // On the CPU of the placement (the mapping of the farm is off)
+        METRIC(metrics->start();)
+        return 0;
+    }
+
+#ifdef METRICS
+    worker_metrics *metrics = nullptr;
+    unsigned phases = 0;
+#endif
+
     int const nw;
+    unsigned cpu = 0;
+
+    // The repartition by the worker speed, every period iterations (zero: never)
+    unsigned period = 0;
+    unsigned phase_count = 0;
+    std::vector<size_t> *starts = nullptr;
+    std::vector<uint64_t> *busy = nullptr;
 };
 
 /**
  * The worker structure
+ *
+ * @tparam V the vector pointer type (a pointer or a column view)
  */
+template <typename V>
 struct Worker : ff_node_t<unsigned> {
     /**
      * @brief The worker constructor.
      *
-     * @param v the pointer to the vector
-     * @param end the end position (included)
-     * @param alignment if false, the odd positions in the pointer are odd positions in the whole array,
-     *                  if true, the odd positions in the pointer are even positions in the whole array.
+     * @param first the pointer to the whole vector
+     * @param starts the first element of every worker, and the last element of the vector:
+     *               the emitter can move them between two phases, by even steps
+     * @param id the worker identifier
+     * @param busy where to add the time spent sorting (null: it's not measured)
      */
-    Worker(vec_type * const v, size_t const end, short alignment) : v{v}, end{end}, alignment{alignment} {}
+    Worker(V const first, std::vector<size_t> const &starts, int const id, uint64_t * const busy)
+            : first{first}, starts{starts}, id{id}, alignment{static_cast<short>(starts[id] % 2)}, busy{busy} {}
 
     /**
      * @brief The business logic of the worker: it computes a sorting phase on its data.
@@ -106,7 +128,14 @@ struct Worker : ff_node_t<unsigned> {
      * @return the number of swaps performed
      */
     unsigned* svc(unsigned *) override {
-        swaps = odd_even_sort(v, alignment, end);
+        METRIC(metrics->wait_done();) // Waiting for the emitter
+
+        auto const start = busy ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+        swaps = odd_even_sort(first + starts[id], alignment, starts[id + 1] - starts[id]);
+        if (busy)
+            *busy += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                     .count();
+        METRIC(metrics->phase_done(half, swaps); if (++half == 2) { half = 0; metrics->iteration_done(); })
 
         alignment = !alignment; // Change phase
 
@@ -117,74 +146,238 @@ struct Worker : ff_node_t<unsigned> {
         return &swaps;
     }
 
-    vec_type * const v;
-    size_t const end;
-    short alignment;
+    int svc_init() override {
+        ff_mapThreadToCpu(static_cast<int>(cpu));
+        METRIC(metrics->start();)
+        return 0;
+    }
+
+#ifdef METRICS
+    worker_metrics *metrics = nullptr;
+    int half = 0;
+#endif
+
+    V const first;
+    std::vector<size_t> const &starts;
+    int const id;
+    short alignment; // If true, the odd positions in my chunk are even positions in the whole array
+    uint64_t * const busy;
+    unsigned cpu = 0;
 
     unsigned swaps = 0;
 };
 
+/**
+ * @brief It sorts the vector with the farm, the emitter in the feedback loop.
+ *
+ * @tparam V the vector pointer type (a pointer or a column view)
+ * @param first the pointer to the first element
+ * @param n the number of elements
+ * @param nw the number of workers
+ * @param where the placement of the threads: the emitter is the controller
+ * @param period the iterations between the repartitions by the worker speed (zero: never)
+ * @param metrics if not null, filled with the metrics of the workers and of the emitter (the last one)
+ * @return false if the farm failed
+ */
+template <typename V>
+bool farm_sort(V const first, size_t const n, long const nw, placement const where, unsigned const period,
+               std::vector<worker_metrics> * const metrics) {
+    METRIC(std::vector<worker_metrics> counters(nw + 1);)
+    auto const cpus = place_threads(static_cast<int>(nw), where);
+
+    // The chunk of the worker i is [starts[i], starts[i + 1]]
+    std::vector<size_t> starts(nw + 1, n - 1);
+    size_t const chunk_len = (n - 1) / nw;
+    long remaining = static_cast<long>((n - 1) % nw);
+    for (long i = 1; i < nw; ++i, --remaining)
+        starts[i] = starts[i - 1] + chunk_len + (remaining > 0);
+    starts[0] = 0;
+    std::vector<uint64_t> busy(period > 0 ? nw * busy_stride : 0);
+
+    Emitter emitter(nw);
+    emitter.cpu = cpus.controller;
+    emitter.period = period;
+    emitter.starts = &starts;
+    emitter.busy = &busy;
+    METRIC(emitter.metrics = &counters[nw];)
+    ff_Farm<> farm([&]() {
+                   std::vector<std::unique_ptr<ff_node>> workers;
+                   for (unsigned i = 0; i < nw; ++i) {
+                       auto worker = make_unique<Worker<V>>(first, starts, i,
+                                                            period > 0 ? &busy[i * busy_stride] : nullptr);
+                       worker->cpu = cpus.workers[i];
+                       METRIC(worker->metrics = &counters[i];)
+                       workers.push_back(std::move(worker));
+                   }
+                   return workers;
+               } (),
+               emitter);
+    farm.remove_collector();
+    farm.wrap_around();
+    farm.no_mapping();
+    auto const done = farm.run_and_wait_end() >= 0;
+    METRIC(if (metrics) *metrics = std::move(counters);)
+    return done;
+}
+
+/**
+ * @brief It creates the random array (or table) of the element type, and it sorts it.
+ *
+ * @tparam T the element type
+ * @param n the length of the array
+ * @param nw the number of workers
+ * @param seed the seed for the random generator
+ * @param keys the number of key columns (zero: a plain array)
+ * @param payloads the number of payload columns
+ * @param d the distribution of the values
+ * @param where the placement of the threads
+ * @param period the iterations between the repartitions by the worker speed (zero: never)
+ * @param metrics_path where to write the metrics of the workers (empty: nowhere)
+ * @param files the input, sorted in place instead of the random array, and the output
+ * @return false if the farm failed
+ */
+template <typename T>
+bool run(size_t const n, long const nw, unsigned const seed, size_t const keys, size_t const payloads,
+         distribution const &d, placement const where, unsigned const period, std::string const &metrics_path,
+         binary_files const &files) {
+    auto const min = element_traits<T>::min(), max = element_traits<T>::max();
+
+    // Create the vector
+    std::vector<T> v;
+    std::unique_ptr<random_table<T>> table;
+    if (keys > 0)
+        table = std::make_unique<random_table<T>>(n, keys, payloads, min, max, seed, d);
+    else if (!files.input.is_open())
+        v = create_vector<T>(d, n, min, max, seed);
+    auto const first = files.input.is_open() ? files.input.data<T>() : v.data();
+
+    auto const start_time = std::chrono::steady_clock::now();
+    std::vector<worker_metrics> metrics;
+#ifdef PERF_COUNTERS
+    auto const collect = &metrics; // The counters are always reported
+#else
+    auto const collect = metrics_path.empty() ? nullptr : &metrics;
+#endif
+    if (!(table ? farm_sort(table->view(), n, nw, where, period, collect)
+                : farm_sort(first, n, nw, where, period, collect)))
+        return false;
+    auto const duration = elapsed_ms(start_time);
+
+    std::cout << "Time: " << duration << " ms" << std::endl;
+
+#ifdef PERF_COUNTERS
+    print_counters(metrics); // The emitter is the last one
+#endif
+    if (!metrics_path.empty() && !write_metrics(metrics_path, metrics))
+        std::cout << "Error writing the metrics in " << metrics_path << std::endl;
+
+    assert(table ? table->is_sorted() : std::is_sorted(first, first + n));
+
+    if (!files.output.empty()) {
+        auto const error = write_binary(files.output, first, n, files.type, files.header);
+        if (!error.empty())
+            std::cout << error << std::endl;
+    }
+    return true;
+}
+
 /**
  * @brief the starting method
  *
  * @return the exit status
  */
 int main(int argc, char const *argv[]) {
+    auto const options = parse_options(argc, argv);
     if (argc < 3) {
         std::cout << "Usage is " << argv[0]
-                  << " n nw [seed]" << std::endl;
+                  << " n nw [seed] (nw 0: one per allowed CPU within the quota, less the emitter)"
+                  << " [--placement=" << placement_names << "] [--rebalance[=iterations]]"
+                  << " [--keys=columns] [--payloads=columns]"
+                  << " [--type=" << element_types << "] [--distribution=" << distribution_names << "]"
+                  << " [--metrics=file.json|file.csv]"
+                  << " [--input=file (n 0: its length)] [--map=private|shared] [--output=file] [--header]"
+                  << std::endl;
         return -1;
     }
 
-    auto const n  = strtol(argv[1], nullptr, 10); // Array length
-    auto const nw = strtol(argv[2], nullptr, 10);
+    auto n  = strtol(argv[1], nullptr, 10); // Array length
+    auto nw = strtol(argv[2], nullptr, 10);
+
+    // Binary mode: the array of a file, mapped and sorted in place, and the sorted array written to a file
+    binary_files files;
+    auto const file_error = open_binary_files(options, n, files);
+    if (!file_error.empty()) {
+        std::cout << file_error << std::endl;
+        return -1;
+    }
 
-    if (n < 1 || nw < 1) {
-        std::cout << "n and nw must be greater than zero" << std::endl;
+    if (n < 1 || nw < 0) {
+        std::cout << "n must be greater than zero, nw not negative" << std::endl;
         return -1;
     }
+    if (nw == 0)
+        nw = std::min<long>(n, default_workers()); // One per allowed CPU within the quota, less the emitter
 
     if (n < nw) {
         std::cout << "nw must be greater than n" << std::endl;
         return -1;
     }
 
-    // Create the vector
-    std::vector<vec_type> v;
-    if (argc > 3)
-        v = create_random_vector<vec_type>(n, MIN, MAX, strtol(argv[3], nullptr, 10));
-    else
-        v = create_random_vector<vec_type>(n, MIN, MAX);
+    // Key-value mode: the rows of a table, sorted by the key columns, with the payload columns alongside
+    auto const keys     = strtoul(get_option(options, "keys", "0").c_str(), nullptr, 10);
+    auto const payloads = strtoul(get_option(options, "payloads", "0").c_str(), nullptr, 10);
+    if (keys > max_key_columns || payloads > max_payload_columns || (keys == 0 && payloads > 0)) {
+        std::cout << "keys must be between 1 and " << max_key_columns << ", payloads at most "
+                  << max_payload_columns << std::endl;
+        return -1;
+    }
+    if (keys > 0 && (files.input.is_open() || !files.output.empty())) {
+        std::cout << "The binary files hold plain arrays (no --keys)" << std::endl;
+        return -1;
+    }
+    auto const seed = argc > 3 ? static_cast<unsigned>(strtol(argv[3], nullptr, 10)) : std::random_device{}();
 
-    ffTime(START_TIME);
-    Emitter emitter(nw);
-    ff_Farm<> farm([&]() {
-                   std::vector<std::unique_ptr<ff_node>> workers;
-                   auto const ptr = v.data();
-                   size_t const chunk_len = (v.size() - 1) / nw;
-                   long remaining = static_cast<long>((v.size() - 1) % nw);
-                   size_t offset = 0;
+    distribution d;
+    auto const distribution_name = get_option(options, "distribution", "uniform");
+    if (!parse_distribution(distribution_name, d)) {
+        std::cout << "Unknown distribution " << distribution_name << std::endl;
+        return -1;
+    }
 
-                   for (unsigned i = 0; i < nw; ++i) {
-                       workers.push_back(make_unique<Worker>(
-                               ptr + offset, chunk_len + (remaining > 0), offset % 2));
-                       offset += chunk_len + (remaining > 0);
-                       --remaining;
-                   }
-                   return workers;
-               } (),
-               emitter);
-    farm.remove_collector();
-    farm.wrap_around();
-    if (farm.run_and_wait_end() < 0) {
-        error("running farm");
-        return EXIT_FAILURE;
+    placement where;
+    auto const placement_name = get_option(options, "placement", "compact");
+    if (!parse_placement(placement_name, where)) {
+        std::cout << "Unknown placement " << placement_name << std::endl;
+        return -1;
     }
-    ffTime(STOP_TIME);
 
-    std::cout << "Time: " << ffTime(GET_TIME) << " ms" << std::endl;
+    // Repartition of the chunks by the worker speed: without a period, every 16 iterations
+    auto const period = options.count("rebalance") == 0 ? 0u
+                        : get_option(options, "rebalance", "").empty() ? 16u
+                        : static_cast<unsigned>(strtoul(get_option(options, "rebalance", "").c_str(), nullptr, 10));
 
-    assert(std::is_sorted(v.begin(), v.end()));
+    // Metrics of the workers and of the emitter, in JSON or CSV (by the extension)
+    auto const metrics_path = get_option(options, "metrics", "");
+#ifndef METRICS
+    if (!metrics_path.empty()) {
+        std::cout << "The metrics are not compiled: build with -DMETRICS" << std::endl;
+        return -1;
+    }
+#endif
+
+    // The element type is chosen at run time among the compiled instantiations
+    bool ok = true;
+    auto const sort = [&](auto element) {
+        ok = run<decltype(element)>(n, nw, seed, keys, payloads, d, where, period, metrics_path, files);
+    };
+    if (!dispatch_type(files.type, sort)) {
+        std::cout << "Unknown type " << files.type << std::endl;
+        return -1;
+    }
+    if (!ok) {
+        error("running farm");
+        return EXIT_FAILURE;
+    }
 
     return 0;
 }
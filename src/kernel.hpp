@@ -0,0 +1,179 @@
+/**
+ * @file   kernel.hpp
+ * @brief  It contains the odd-even sorting phase kernels, scalar and vectorized
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_KERNEL_HPP
+#define ODD_EVEN_SORT_KERNEL_HPP
+
+#include <algorithm>   // std::min
+#include <cstddef>
+#include <cstdint>
+#include <type_traits> // std::integral_constant
+
+#include <simd.hpp>
+
+/**
+ * @brief It performs an odd or an even sorting phase on the array, one pair at a time.
+ *
+ * @tparam T the element type
+ * @param v the pointer to the vector
+ * @param phase the phase (odd or even)
+ * @param end the end of the array
+ * @return non-zero if at least one swap has been performed
+ */
+template <typename T>
+unsigned odd_even_sort(T * const v, short const phase, size_t const end, std::false_type) {
+    unsigned swaps = 0;
+    for (size_t i = phase; i < end; i += 2) {
+        auto first = v[i], second = v[i + 1];
+        auto cond = first > second;
+        v[i]     = cond ? second : first;
+        v[i + 1] = cond ? first : second;
+        if (v[i] != first)
+            swaps++;
+    }
+    return swaps;
+}
+
+/**
+ * @brief Vectorized sorting phase, with the register operations of the element type (see simd_ops).
+ *        Every register holds whole pairs: the pair partners are exchanged in the register,
+ *        the min goes to the even lanes and the max to the odd ones, and the swaps are detected
+ *        on the changed bits instead of a per-element counter.
+ *        The pointer is first advanced to the pair boundary selected by the phase,
+ *        so odd offsets and unaligned chunk starts are handled by scalar peeling and unaligned accesses.
+ *
+ * @tparam T the element type
+ * @param v the pointer to the vector
+ * @param phase the phase (odd or even)
+ * @param end the end of the array
+ * @return non-zero if at least one swap has been performed
+ */
+template <typename T>
+unsigned odd_even_sort(T * const v, short const phase, size_t const end, std::true_type) {
+    using ops = simd_ops<T>;
+    size_t constexpr lanes = sizeof(typename ops::reg) / sizeof(T);
+
+    if (end <= static_cast<size_t>(phase))
+        return 0;
+
+    auto p = v + phase;
+    auto pairs = (end - phase + 1) / 2;
+    unsigned swaps = 0;
+
+    // Scalar peeling until the pairs are aligned to the register size (if the parity allows it)
+    if (reinterpret_cast<uintptr_t>(p) % (2 * sizeof(T)) == 0) {
+        while (pairs > 0 && reinterpret_cast<uintptr_t>(p) % sizeof(typename ops::reg) != 0) {
+            swaps |= odd_even_sort(p, 0, 1, std::false_type{});
+            p += 2;
+            --pairs;
+        }
+    }
+
+    auto changed = ops::zero();
+    for (; pairs >= lanes / 2; pairs -= lanes / 2, p += lanes) {
+        auto const x      = ops::load(p);
+        auto const sorted = ops::sort_pairs(x);
+        changed = ops::changes(changed, x, sorted);
+        ops::store(p, sorted);
+    }
+    swaps |= ops::any(changed);
+
+    // Remaining pairs
+    if (pairs > 0)
+        swaps |= odd_even_sort(p, 0, 2 * pairs - 1, std::false_type{});
+
+    return swaps;
+}
+
+/**
+ * @brief It performs an odd or an even sorting phase on the array,
+ *        with the widest vectorized kernel of the element type, or the scalar one if there is none.
+ *
+ * @tparam T the element type
+ * @param v the pointer to the vector
+ * @param phase the phase (odd or even)
+ * @param end the end of the array
+ * @return non-zero if at least one swap has been performed
+ */
+template <typename T>
+unsigned odd_even_sort(T * const v, short const phase, size_t const end) {
+    return odd_even_sort(v, phase, end, std::integral_constant<bool, simd_ops<T>::enabled>{});
+}
+
+/**
+ * @brief The bytes of an element, to size the tiles.
+ *
+ * @tparam T the element type
+ * @return the size of the element
+ */
+template <typename T>
+size_t row_bytes(T * const) {
+    return sizeof(T);
+}
+
+// Pairs of a segment in the tracked kernel: the swaps are located with this granularity
+size_t constexpr tracking_segment = 128;
+
+/**
+ * @brief It performs a sorting phase on the pairs with the left index in [lo, hi), tracking where the swaps happened.
+ *        The pairs are processed in segments by the kernels above, so the swaps are located at segment granularity.
+ *
+ * @tparam T the vector pointer type
+ * @param v the pointer to the vector
+ * @param phase the phase (odd or even)
+ * @param lo the first pair (included)
+ * @param hi the last pair (excluded)
+ * @param first set to the first pair of the first segment with swaps
+ * @param last set to the end of the last segment with swaps
+ * @return non-zero if at least one swap has been performed (otherwise first and last are untouched)
+ */
+template <typename T>
+unsigned odd_even_sort_tracked(T const v, short const phase, size_t const lo, size_t const hi,
+                               size_t &first, size_t &last) {
+    unsigned swaps = 0;
+    for (auto start = lo + ((lo & 1) != static_cast<size_t>(phase)); start < hi; start += 2 * tracking_segment) {
+        auto const stop = std::min(start + 2 * tracking_segment, hi);
+        if (odd_even_sort(v + start, 0, stop - start)) {
+            if (!swaps)
+                first = start;
+            last  = stop;
+            swaps = 1;
+        }
+    }
+    return swaps;
+}
+
+/**
+ * @brief It performs a sorting phase as odd_even_sort, reporting the swaps of the pairs on the two ends
+ *        of the array: the elements shared with the neighbours.
+ *
+ * @tparam T the vector pointer type
+ * @param v the pointer to the vector
+ * @param phase the phase (odd or even)
+ * @param end the end of the array
+ * @param edge set to the changed ends: bit 0 the first element, bit 1 the last one
+ * @return non-zero if at least one swap has been performed
+ */
+template <typename T>
+unsigned odd_even_sort_edges(T const v, short const phase, size_t const end, unsigned &edge) {
+    size_t lo = phase, hi = end; // The inner pairs, with the left index in [lo, hi)
+    edge = 0;
+    if (phase == 0 && end > 0) {
+        if (odd_even_sort(v, 0, 1))
+            edge |= end == 1 ? 3 : 1; // A single pair has both the ends
+        lo = 2;
+    }
+    if (lo < end && (end - 1 - phase) % 2 == 0) {
+        hi = end - 1;
+        if (odd_even_sort(v + hi, 0, 1))
+            edge |= 2;
+    }
+    auto const swaps = lo < hi ? odd_even_sort(v + lo, 0, hi - lo) : 0;
+    return swaps | edge;
+}
+
+#endif // ODD_EVEN_SORT_KERNEL_HPP
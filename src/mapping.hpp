@@ -0,0 +1,142 @@
+/**
+ * @file   mapping.hpp
+ * @brief  It contains the memory mapping of the binary files, for the arrays larger than the memory
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_MAPPING_HPP
+#define ODD_EVEN_SORT_MAPPING_HPP
+
+#include <algorithm> // std::min
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>  // strerror
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * A file mapped in memory: shared (the writes go to the file) or private (the written pages are copied, the file
+ * is untouched). The kernel pages a shared file in and out, so the mapping can be larger than the memory;
+ * the advices tell it what comes next.
+ */
+class mapped_file {
+public:
+    mapped_file() = default;
+    mapped_file(mapped_file const &) = delete;
+    mapped_file &operator=(mapped_file const &) = delete;
+
+    ~mapped_file() {
+        if (address != MAP_FAILED)
+            munmap(address, length);
+        if (fd >= 0)
+            close(fd);
+    }
+
+    /**
+     * @brief It maps a whole file, for reading and writing.
+     *
+     * @param path the file
+     * @param shared if true, the writes go to the file
+     * @param populate if true, the file is read before returning (Linux only): no page faults later
+     * @return the error message, empty if the file is mapped
+     */
+    std::string open(std::string const &path, bool const shared = true, bool const populate = false) {
+        fd = ::open(path.c_str(), shared ? O_RDWR : O_RDONLY);
+        if (fd < 0)
+            return path + ": " + strerror(errno);
+        struct stat info{};
+        if (fstat(fd, &info) != 0)
+            return path + ": " + strerror(errno);
+        length = static_cast<size_t>(info.st_size);
+        if (length == 0)
+            return path + " is empty";
+        int flags = shared ? MAP_SHARED : MAP_PRIVATE;
+#ifdef LINUX_MACHINE
+        if (populate)
+            flags |= MAP_POPULATE;
+#else
+        (void) populate;
+#endif
+        address = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, fd, 0);
+        if (address == MAP_FAILED)
+            return path + ": " + strerror(errno);
+        madvise(address, length, MADV_SEQUENTIAL); // Aggressive read-ahead, and the pages behind dropped early
+        return "";
+    }
+
+    /**
+     * @return the first byte of the mapping
+     */
+    void *data() const {
+        return address;
+    }
+
+    /**
+     * @return the length of the file, in bytes
+     */
+    size_t size() const {
+        return length;
+    }
+
+    /**
+     * @brief It asks the kernel to read a range ahead, without waiting for it.
+     *
+     * @param first the first byte of the range, in the mapping
+     * @param bytes the length of the range
+     */
+    void read_ahead(void const *first, size_t const bytes) const {
+        size_t offset, span;
+        if (page_range(first, bytes, offset, span))
+            madvise(static_cast<char *>(address) + offset, span, MADV_WILLNEED);
+    }
+
+    /**
+     * @brief It starts writing a range back to the file, without waiting for it:
+     *        its pages are clean by the time the range is needed again, or evicted.
+     *
+     * @param first the first byte of the range, in the mapping
+     * @param bytes the length of the range
+     */
+    void write_back(void const *first, size_t const bytes) const {
+        size_t offset, span;
+        if (!page_range(first, bytes, offset, span))
+            return;
+#ifdef LINUX_MACHINE
+        sync_file_range(fd, static_cast<off_t>(offset), static_cast<off_t>(span), SYNC_FILE_RANGE_WRITE);
+#else
+        msync(static_cast<char *>(address) + offset, span, MS_ASYNC);
+#endif
+    }
+
+private:
+    /**
+     * @brief It widens a range of the mapping to whole pages.
+     *
+     * @param first the first byte of the range
+     * @param bytes the length of the range
+     * @param offset the offset of its first page
+     * @param span the length of its pages, within the mapping
+     * @return false if the range is empty
+     */
+    bool page_range(void const *first, size_t const bytes, size_t &offset, size_t &span) const {
+        if (bytes == 0)
+            return false;
+        auto const page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        auto const begin = static_cast<size_t>(static_cast<char const *>(first) - static_cast<char *>(address));
+        offset = begin / page * page;
+        span = std::min(begin + bytes, length) - offset;
+        return true;
+    }
+
+    int fd = -1;
+    void *address = MAP_FAILED;
+    size_t length = 0;
+};
+
+#endif // ODD_EVEN_SORT_MAPPING_HPP
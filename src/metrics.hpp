@@ -0,0 +1,222 @@
+/**
+ * @file   metrics.hpp
+ * @brief  It contains the per-worker instrumentation, compiled only with -DMETRICS
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_METRICS_HPP
+#define ODD_EVEN_SORT_METRICS_HPP
+
+#include <algorithm> // std::max
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef LINUX_MACHINE
+#include <sys/resource.h> // getrusage
+#endif
+
+// The hardware counters are read at the same points of the timers, so they bring the metrics with them
+#ifdef PERF_COUNTERS
+#ifndef METRICS
+#define METRICS
+#endif
+#include <perf.hpp>
+#endif
+
+// The statements of the instrumentation: they disappear without -DMETRICS, so it costs nothing when it's off
+#ifdef METRICS
+#define METRIC(...) __VA_ARGS__
+#else
+#define METRIC(...)
+#endif
+
+/**
+ * What a worker did in an iteration, in nanoseconds
+ */
+struct iteration_metrics {
+    uint64_t phase_ns[2] = {0, 0}; // Computing the two halves of the iteration (the odd and the even phase)
+    uint64_t spin_ns     = 0;      // Waiting for the neighbours (or the partner)
+    uint64_t barrier_ns  = 0;      // Waiting at the barrier
+    uint64_t swaps       = 0;      // As returned by the kernels: a count, or a flag for the vectorized ones
+};
+
+/**
+ * The metrics of a worker: the iterations, and the stopwatch that splits them
+ */
+struct alignas(64) worker_metrics {
+    std::vector<iteration_metrics> iterations;
+    iteration_metrics current;
+    std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+#ifdef PERF_COUNTERS
+    perf_group perf; // Opened by the worker itself: the counters follow the thread
+#endif
+
+    /**
+     * @brief It starts the stopwatch (and the counters) from the worker thread.
+     */
+    void start() {
+#ifdef PERF_COUNTERS
+        perf.open();
+#endif
+        lap();
+    }
+
+    /**
+     * @return the nanoseconds from the previous lap
+     */
+    uint64_t lap() {
+        auto const now = std::chrono::steady_clock::now();
+        auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count();
+        last = now;
+        return ns;
+    }
+
+    /**
+     * @brief It closes the computation of a half of the iteration.
+     *
+     * @param half the half (zero or one)
+     * @param swaps the swaps returned by the kernel
+     */
+    void phase_done(int const half, uint64_t const swaps) {
+        current.phase_ns[half] += lap();
+        current.swaps += swaps;
+#ifdef PERF_COUNTERS
+        perf.region_done(perf_sort);
+#endif
+    }
+
+    /**
+     * @brief It closes a wait for the neighbours.
+     */
+    void spin_done() {
+        current.spin_ns += lap();
+#ifdef PERF_COUNTERS
+        perf.region_done(perf_wait);
+#endif
+    }
+
+    /**
+     * @brief It closes a barrier wait.
+     */
+    void wait_done() {
+        current.barrier_ns += lap();
+#ifdef PERF_COUNTERS
+        perf.region_done(perf_wait);
+#endif
+    }
+
+    /**
+     * @brief It closes a barrier wait, and the iteration with it.
+     */
+    void barrier_done() {
+        wait_done();
+        iteration_done();
+    }
+
+    /**
+     * @brief It closes the iteration.
+     */
+    void iteration_done() {
+        iterations.push_back(current);
+        current = iteration_metrics{};
+    }
+};
+
+/**
+ * @return the peak resident set size of the process, in KB (zero if it's unknown)
+ */
+inline long peak_rss_kb() {
+#ifdef LINUX_MACHINE
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        return usage.ru_maxrss;
+#endif
+    return 0;
+}
+
+/**
+ * @brief It writes the metrics of a run: CSV (one row per worker and iteration) if the path ends with ".csv",
+ *        JSON (the totals of every worker, and its iterations) otherwise.
+ *
+ * @param path the file path
+ * @param workers the metrics of every worker
+ * @return false if the file can't be written
+ */
+inline bool write_metrics(std::string const &path, std::vector<worker_metrics> const &workers) {
+    std::ofstream file{path};
+    size_t iterations = 0;
+    for (auto const &worker : workers)
+        iterations = std::max(iterations, worker.iterations.size());
+
+    if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0) {
+        file << "worker,iteration,phase0_ns,phase1_ns,spin_ns,barrier_ns,swaps\n";
+        for (size_t w = 0; w < workers.size(); ++w) {
+            auto const &records = workers[w].iterations;
+            for (size_t i = 0; i < records.size(); ++i)
+                file << w << ',' << i << ',' << records[i].phase_ns[0] << ',' << records[i].phase_ns[1] << ','
+                     << records[i].spin_ns << ',' << records[i].barrier_ns << ',' << records[i].swaps << '\n';
+        }
+        return static_cast<bool>(file);
+    }
+
+    file << "{\n  \"iterations\": " << iterations << ",\n  \"peak_rss_kb\": " << peak_rss_kb()
+         << ",\n  \"workers\": [";
+    for (size_t w = 0; w < workers.size(); ++w) {
+        iteration_metrics total;
+        std::string records;
+        for (auto const &record : workers[w].iterations) {
+            total.phase_ns[0] += record.phase_ns[0];
+            total.phase_ns[1] += record.phase_ns[1];
+            total.spin_ns     += record.spin_ns;
+            total.barrier_ns  += record.barrier_ns;
+            total.swaps       += record.swaps;
+            records += (records.empty() ? "[" : ", [") + std::to_string(record.phase_ns[0]) + ", "
+                       + std::to_string(record.phase_ns[1]) + ", " + std::to_string(record.spin_ns) + ", "
+                       + std::to_string(record.barrier_ns) + ", " + std::to_string(record.swaps) + "]";
+        }
+        file << (w == 0 ? "\n" : ",\n") << "    {\"worker\": " << w
+             << ", \"iterations\": " << workers[w].iterations.size()
+             << ", \"phase_ns\": [" << total.phase_ns[0] << ", " << total.phase_ns[1] << "]"
+             << ", \"spin_ns\": " << total.spin_ns << ", \"barrier_ns\": " << total.barrier_ns
+             << ", \"swaps\": " << total.swaps;
+#ifdef PERF_COUNTERS
+        file << ",\n     \"perf\": {";
+        for (int r = 0; r < perf_regions; ++r) {
+            file << (r == 0 ? "\"" : ", \"") << perf_region_names[r] << "\": {";
+            for (int e = 0; e < perf_events; ++e) {
+                file << (e == 0 ? "\"" : ", \"") << perf_event_names[e] << "\": ";
+                if (workers[w].perf.available[e])
+                    file << workers[w].perf.totals[r][e];
+                else
+                    file << "null";
+            }
+            file << "}";
+        }
+        file << "}";
+#endif
+        file << ",\n     \"per_iteration\": [" << records << "]}";
+    }
+    file << "\n  ],\n  \"per_iteration_columns\": "
+         << "[\"phase0_ns\", \"phase1_ns\", \"spin_ns\", \"barrier_ns\", \"swaps\"]\n}\n";
+    return static_cast<bool>(file);
+}
+
+#ifdef PERF_COUNTERS
+/**
+ * @brief It prints the hardware counters of every worker.
+ *
+ * @param workers the metrics of every worker
+ */
+inline void print_counters(std::vector<worker_metrics> const &workers) {
+    std::vector<perf_group const *> groups;
+    for (auto const &worker : workers)
+        groups.push_back(&worker.perf);
+    print_perf(groups);
+}
+#endif
+
+#endif // ODD_EVEN_SORT_METRICS_HPP
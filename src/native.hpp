@@ -0,0 +1,688 @@
+/**
+ * @file   native.hpp
+ * @brief  It contains the business logic of the STD thread parallel implementation
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_NATIVE_HPP
+#define ODD_EVEN_SORT_NATIVE_HPP
+
+#include <algorithm> // std::sort, std::copy, std::min, std::max
+#include <chrono>
+#include <cstdint>
+#include <memory>    // Smart pointers
+#include <utility>   // std::move
+#include <vector>
+
+#include <balance.hpp>
+#include <barrier.hpp>
+#include <kernel.hpp>
+#include <metrics.hpp>
+#include <tiling.hpp>
+#include <wait.hpp>
+
+/**
+ * The state shared by the workers and the controller of a run
+ */
+struct native_state {
+    short cache_padding;          // Distance between the positions of two workers in the vectors below
+    bool finished = false;
+    wait_policy policy;
+    std::vector<unsigned> phases; // The phases progress of every worker
+    std::vector<unsigned> swaps;  // The swaps of every worker in the current iteration
+    std::vector<unsigned> edges;  // The swaps on the shared elements, for the dirty-range workers
+    std::vector<uint64_t> busy;   // The busy time of every worker in a period, two slots, for the adaptive workers
+    std::vector<unsigned> parking; // The parking state of every worker (see park_states), for the parking workers
+    std::vector<unsigned> quiet;  // The iterations in a row without swaps of every worker, two slots, for the same
+    std::unique_ptr<barrier> sync;
+    METRIC(std::vector<worker_metrics> metrics;) // One per worker
+
+    native_state(int nw, short cache_padding, wait_policy policy, std::unique_ptr<barrier> sync)
+            : cache_padding{cache_padding}, policy{policy},
+              phases(nw * cache_padding, 0), swaps(nw * cache_padding, 0), edges(2 * nw * cache_padding, 0),
+              busy(2 * nw * cache_padding, 0), parking(nw * cache_padding, 0), quiet(2 * nw * cache_padding, 0),
+              sync{std::move(sync)} METRIC(, metrics(nw)) {}
+
+    /**
+     * @brief It prepares the state for another run on the same threads. The barrier is ready:
+     *        every run ends with a complete episode, with all the participants.
+     */
+    void reset() {
+        finished = false;
+        for (auto vector : {&phases, &swaps, &edges, &parking, &quiet})
+            std::fill(vector->begin(), vector->end(), 0);
+        std::fill(busy.begin(), busy.end(), 0);
+    }
+};
+
+/**
+ * The parking states of a worker. A parking worker is leaving the barrier and the neighbours handshakes, and it can't
+ * be woken before it's parked (out of them); the waker moves it to waking while it prepares its return, then to where
+ * it has to resume.
+ */
+enum park_states : unsigned {
+    worker_running, worker_parking, worker_parked, worker_waking, resume_phase, resume_barrier
+};
+
+/**
+ * @brief It waits my neighbours to reach my phase.
+ *
+ * @tparam State the shared state type (see native_state)
+ * @param thid the thread identifier
+ * @param nw the number of workers
+ * @param state the state shared by the threads of the run
+ */
+template <typename State>
+void wait_neighbours(int const thid, int const nw, State &state) {
+    auto const cache_padding = state.cache_padding;
+    auto &phases = state.phases;
+    auto const mine = phases[thid * cache_padding];
+    auto const same_phase = [=](unsigned value) { return value == mine; };
+    if (thid < nw - 1)
+        wait_until(&phases[(thid + 1) * cache_padding], same_phase, state.policy);
+    if (thid > 0)
+        wait_until(&phases[(thid - 1) * cache_padding], same_phase, state.policy);
+}
+
+/**
+ * @brief The business logic of the worker.
+ *
+ * @tparam T the vector pointer type
+ * @tparam State the shared state type: native_state, or one with the same members out of the process
+ * @param thid the thread identifier
+ * @param v the pointer to the vector
+ * @param end the end position (included)
+ * @param offset if false, the odd positions in the pointer are odd positions in the whole array,
+ *               if true, the odd positions in the pointer are even positions in the whole array.
+ * @param state the state shared by the threads of the run
+ */
+template <typename T, typename State = native_state>
+void thread_body(int thid, T const v, size_t const end, bool const offset, int const nw, State &state) {
+    auto const cache_padding = state.cache_padding;
+    auto const pos = thid * cache_padding; // Cache-aware position in phases and swaps array
+    auto &phases = state.phases;
+    auto &swaps  = state.swaps;
+    auto &sync   = *state.sync;
+
+    /*
+     * I know that repeating code is bad practice, but in this case
+     * is the only way to achieve better performances.
+     * The key for the performance lies in the explicit '1' and '0' in the function call,
+     * and in the asynchronous wait for the neighbours threads.
+     */
+    METRIC(auto &metrics = state.metrics[thid]; metrics.start();)
+    unsigned phase_swaps;
+
+    if (!offset) {
+        while (!state.finished) {
+            phase_swaps = odd_even_sort(v, 1, end); // Odd phase
+            swaps[pos] |= phase_swaps;
+            METRIC(metrics.phase_done(0, phase_swaps);)
+
+            phases[pos]++; // Ready for the next phase
+            notify_all(&phases[pos], state.policy);
+
+            // Wait my neighbours to be ready
+            wait_neighbours(thid, nw, state);
+            METRIC(metrics.spin_done();)
+
+            phase_swaps = odd_even_sort(v, 0, end); // Even phase
+            swaps[pos] |= phase_swaps;
+            METRIC(metrics.phase_done(1, phase_swaps);)
+
+            sync.wait(thid);
+            METRIC(metrics.barrier_done();)
+            swaps[pos] = 0;
+        }
+    } else {
+        while (!state.finished) {
+            phase_swaps = odd_even_sort(v, 0, end); // Odd phase
+            swaps[pos] |= phase_swaps;
+            METRIC(metrics.phase_done(0, phase_swaps);)
+
+            phases[pos]++; // Ready for the next phase
+            notify_all(&phases[pos], state.policy);
+
+            // Wait my neighbours to be ready
+            wait_neighbours(thid, nw, state);
+            METRIC(metrics.spin_done();)
+
+            phase_swaps = odd_even_sort(v, 1, end); // Even phase
+            swaps[pos] |= phase_swaps;
+            METRIC(metrics.phase_done(1, phase_swaps);)
+
+            sync.wait(thid);
+            METRIC(metrics.barrier_done();)
+            swaps[pos] = 0;
+        }
+    }
+}
+
+/**
+ * @brief The business logic of the adaptive worker: it sorts as thread_body, and it measures its busy time.
+ *        Every period iterations, after the barrier, every worker moves the chunk boundaries by the busy times
+ *        of the period (see rebalance): the same computation on the same data, so they all agree.
+ *        The busy times of two consecutive periods go in two slots, since a worker can publish the next one
+ *        while a slower one is still reading.
+ *
+ * @tparam T the vector pointer type
+ * @param thid the thread identifier
+ * @param first the pointer to the whole vector
+ * @param starts the first element of every worker, and the last element of the vector
+ * @param nw the number of workers
+ * @param period the iterations between two repartitions
+ * @param state the state shared by the threads of the run
+ */
+template <typename T>
+void adaptive_thread_body(int thid, T const first, std::vector<size_t> starts, int const nw, unsigned const period,
+                          native_state &state) {
+    auto const cache_padding = state.cache_padding;
+    auto const pos = thid * cache_padding; // Cache-aware position in phases and swaps array
+    auto &phases = state.phases;
+    auto &swaps  = state.swaps;
+    auto &sync   = *state.sync;
+    short const odd = starts[thid] % 2 == 0; // The chunk parity never changes: neither the phases do
+
+    METRIC(auto &metrics = state.metrics[thid]; metrics.start();)
+    unsigned phase_swaps;
+    unsigned iterations = 0;
+    uint64_t busy = 0;
+    using clock = std::chrono::steady_clock;
+    auto const since = [](clock::time_point start) {
+        return static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+    };
+
+    while (!state.finished) {
+        auto const v = first + starts[thid];
+        auto const end = starts[thid + 1] - starts[thid];
+
+        auto start = clock::now();
+        phase_swaps = odd_even_sort(v, odd, end); // Odd phase
+        busy += since(start);
+        swaps[pos] |= phase_swaps;
+        METRIC(metrics.phase_done(0, phase_swaps);)
+
+        phases[pos]++; // Ready for the next phase
+        notify_all(&phases[pos], state.policy);
+
+        // Wait my neighbours to be ready
+        wait_neighbours(thid, nw, state);
+        METRIC(metrics.spin_done();)
+
+        start = clock::now();
+        phase_swaps = odd_even_sort(v, !odd, end); // Even phase
+        busy += since(start);
+        swaps[pos] |= phase_swaps;
+        METRIC(metrics.phase_done(1, phase_swaps);)
+
+        auto const slot = (iterations / period) % 2 * nw * cache_padding;
+        auto const repartition = ++iterations % period == 0;
+        if (repartition) {
+            state.busy[slot + pos] = busy;
+            busy = 0;
+        }
+
+        sync.wait(thid);
+        METRIC(metrics.barrier_done();)
+        swaps[pos] = 0;
+
+        if (repartition)
+            rebalance(starts, &state.busy[slot], cache_padding);
+    }
+}
+
+/**
+ * @brief It waits my neighbours to reach my phase, or to be parked.
+ *
+ * @param thid the thread identifier
+ * @param nw the number of workers
+ * @param state the state shared by the threads of the run
+ */
+inline void wait_running_neighbours(int const thid, int const nw, native_state &state) {
+    auto const cache_padding = state.cache_padding;
+    auto &phases = state.phases;
+    auto const mine = phases[thid * cache_padding];
+    for (auto neighbour : {thid + 1, thid - 1}) {
+        if (neighbour < 0 || neighbour >= nw)
+            continue;
+        auto const parking = &state.parking[neighbour * cache_padding];
+        wait_until(&phases[neighbour * cache_padding], [=](unsigned value) {
+            auto const park = __atomic_load_n(parking, __ATOMIC_ACQUIRE);
+            return value == mine || park == worker_parking || park == worker_parked || park == worker_waking;
+        }, state.policy);
+    }
+}
+
+/**
+ * @brief It wakes the parked neighbours whose shared element I changed. A neighbour still parking, at the beginning
+ *        of this iteration, is waited until it's parked: it must leave the barrier before I join it back.
+ *
+ * @param thid the thread identifier
+ * @param nw the number of workers
+ * @param edge the ends of my chunk changed by my last phase (see odd_even_sort_edges)
+ * @param resume where the neighbours resume: resume_phase after my first phase, resume_barrier after the second
+ * @param state the state shared by the threads of the run
+ */
+inline void wake_neighbours(int const thid, int const nw, unsigned const edge, unsigned const resume,
+                            native_state &state) {
+    auto const cache_padding = state.cache_padding;
+    for (auto neighbour : {thid - 1, thid + 1}) {
+        auto const shared = neighbour < thid ? 1u : 2u; // My first element is the last one of the left neighbour
+        if (!(edge & shared) || neighbour < 0 || neighbour >= nw)
+            continue;
+        auto &parking = state.parking[neighbour * cache_padding];
+        wait_until(&parking, [](unsigned value) { return value != worker_parking; }, state.policy);
+        unsigned expected = worker_parked;
+        if (!__atomic_compare_exchange_n(&parking, &expected, worker_waking, false, __ATOMIC_ACQ_REL,
+                                         __ATOMIC_ACQUIRE))
+            continue; // Running, or already woken by its other neighbour
+        __atomic_store_n(&state.phases[neighbour * cache_padding], state.phases[thid * cache_padding],
+                         __ATOMIC_RELEASE);
+        state.sync->join(neighbour); // I have not arrived yet: the episode waits it
+        __atomic_store_n(&parking, resume, __ATOMIC_RELEASE);
+        notify_all(&parking, wait_policy::block);
+    }
+}
+
+/**
+ * @brief It parks the calling worker until a neighbour changes a shared element, or the run ends.
+ *        The parked worker sleeps whatever the wait policy, to leave the core to the others.
+ *
+ * @param thid the thread identifier
+ * @param state the state shared by the threads of the run
+ * @return where to resume (resume_phase or resume_barrier), worker_running if the run ended
+ *         (then the last barrier episode waits me)
+ */
+inline unsigned park(int const thid, native_state &state) {
+    auto const pos = thid * state.cache_padding;
+    auto &parking = state.parking[pos];
+    __atomic_store_n(&parking, worker_parking, __ATOMIC_SEQ_CST);
+    // A neighbour waiting for my phase wakes up, and it sees me parking
+    __atomic_store_n(&state.phases[pos], 0u, __ATOMIC_SEQ_CST);
+    notify_all(&state.phases[pos], state.policy);
+    state.sync->leave(thid);
+    // Only now I can be woken: the waker's phase and its join must come after mine
+    __atomic_store_n(&parking, worker_parked, __ATOMIC_SEQ_CST);
+    notify_all(&parking, state.policy);
+
+    wait_until(&parking, [](unsigned value) { return value != worker_parked && value != worker_waking; },
+               wait_policy::block);
+    auto const resume = __atomic_load_n(&parking, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&parking, worker_running, __ATOMIC_RELAXED);
+    return resume;
+}
+
+/**
+ * @brief The business logic of the parking worker: it sorts as thread_body, but when it and its neighbours
+ *        had no swaps for patience iterations in a row, its chunk can't change until a neighbour changes
+ *        a shared element. Then it parks (see park): the barrier, the handshakes and the controller
+ *        go on without it, and the neighbour that changes a shared element wakes it, to resume
+ *        in the same phase of the others.
+ *        The iterations without swaps are published before the barrier, in a slot per iteration parity.
+ *
+ * @tparam T the vector pointer type
+ * @param thid the thread identifier
+ * @param v the pointer to the vector
+ * @param end the end position (included)
+ * @param offset if false, the odd positions in the pointer are odd positions in the whole array,
+ *               if true, the odd positions in the pointer are even positions in the whole array.
+ * @param patience the iterations without swaps before parking
+ * @param state the state shared by the threads of the run
+ */
+template <typename T>
+void parking_thread_body(int thid, T const v, size_t const end, bool const offset, int const nw,
+                         unsigned const patience, native_state &state) {
+    auto const cache_padding = state.cache_padding;
+    auto const pos = thid * cache_padding; // Cache-aware position in phases and swaps array
+    auto &phases = state.phases;
+    auto &swaps  = state.swaps;
+    auto &sync   = *state.sync;
+    auto const quiet = [&](int w) {
+        if (w < 0 || w >= nw)
+            return true;
+        auto const park = __atomic_load_n(&state.parking[w * cache_padding], __ATOMIC_ACQUIRE);
+        return park == worker_parking || park == worker_parked
+               || state.quiet[phases[pos] % 2 * nw * cache_padding + w * cache_padding] >= patience;
+    };
+
+    METRIC(auto &metrics = state.metrics[thid]; metrics.start();)
+    unsigned phase_swaps, edge;
+    unsigned calm = 0; // My iterations in a row without swaps
+
+    while (!state.finished) {
+        unsigned resume = worker_running;
+        if (calm >= patience && quiet(thid - 1) && quiet(thid + 1)) {
+            resume = park(thid, state);
+            METRIC(metrics.wait_done();)
+            if (resume == worker_running) {
+                sync.wait(thid); // The controller brought me back to the last episode
+                return;
+            }
+            calm = 0;
+        }
+        unsigned iteration_swaps = 0;
+
+        if (resume == worker_running) {
+            phase_swaps = odd_even_sort_edges(v, !offset, end, edge); // Odd phase
+            swaps[pos] |= phase_swaps;
+            iteration_swaps |= phase_swaps;
+            METRIC(metrics.phase_done(0, phase_swaps);)
+
+            phases[pos]++; // Ready for the next phase
+            notify_all(&phases[pos], state.policy);
+        }
+
+        if (resume != resume_barrier) {
+            // Wait my neighbours to be ready, then the parked ones need my first phase
+            wait_running_neighbours(thid, nw, state);
+            if (resume == worker_running)
+                wake_neighbours(thid, nw, edge, resume_phase, state);
+            METRIC(metrics.spin_done();)
+
+            phase_swaps = odd_even_sort_edges(v, offset, end, edge); // Even phase
+            swaps[pos] |= phase_swaps;
+            iteration_swaps |= phase_swaps;
+            METRIC(metrics.phase_done(1, phase_swaps);)
+            wake_neighbours(thid, nw, edge, resume_barrier, state);
+        }
+
+        calm = iteration_swaps ? 0 : calm + 1;
+        state.quiet[phases[pos] % 2 * nw * cache_padding + pos] = calm;
+
+        sync.wait(thid);
+        METRIC(metrics.barrier_done();)
+        swaps[pos] = 0;
+    }
+}
+
+/**
+ * @brief The business logic of the dirty-range worker: a pair can swap only if one of its elements
+ *        has been changed by the previous phase, so every phase works only on the pairs swapped
+ *        in the previous one, widened by one pair on each side.
+ *        The swaps on the shared elements are published in the edges vector before the handshake,
+ *        in a slot per phase of the iteration, since the neighbour can read them while I'm already
+ *        in the next phase.
+ *
+ * @tparam T the vector pointer type
+ * @param thid the thread identifier
+ * @param v the pointer to the vector
+ * @param end the end position (included)
+ * @param offset if false, the odd positions in the pointer are odd positions in the whole array,
+ *               if true, the odd positions in the pointer are even positions in the whole array.
+ * @param state the state shared by the threads of the run (edges: the swaps on the first (bit 0)
+ *              and the last (bit 1) element, two slots per worker)
+ */
+template <typename T>
+void dirty_thread_body(int thid, T const v, size_t const end, bool const offset, int const nw,
+                       native_state &state) {
+    auto const cache_padding = state.cache_padding;
+    auto const pos = thid * cache_padding; // Cache-aware position in phases and swaps array
+    auto &phases = state.phases;
+    auto &swaps  = state.swaps;
+    auto &edges  = state.edges;
+    auto &sync   = *state.sync;
+    auto const has_left_neigh = thid > 0, has_right_neigh = thid < nw - 1;
+    unsigned constexpr first_element = 1, last_element = 2;
+    size_t lo = 0, hi = end; // The dirty pairs of the next phase
+    unsigned whole = 2;      // The phases still to sort whole: the first two, since nothing is known yet
+    METRIC(auto &metrics = state.metrics[thid]; metrics.start();)
+
+    while (!state.finished) {
+        for (int step = 0; step < 2; ++step) {
+            short const phase = offset == step; // Odd phase first
+            if (whole > 0) {
+                --whole;
+                lo = 0;
+                hi = end;
+            }
+
+            // Swaps of the neighbours on my shared elements in the previous phase
+            auto const previous = !step;
+            if (has_left_neigh && (edges[2 * (thid - 1) * cache_padding + previous] & last_element)) {
+                lo = 0;
+                hi = std::max<size_t>(hi, 1);
+            }
+            if (has_right_neigh && (edges[2 * (thid + 1) * cache_padding + previous] & first_element)) {
+                lo = std::min(lo, end - 1);
+                hi = end;
+            }
+
+            size_t first = 0, last = 0;
+            unsigned edge = 0;
+            if (lo < hi && odd_even_sort_tracked(v, phase, lo, hi, first, last)) {
+                swaps[pos] = 1;
+                edge = (first == 0 ? first_element : 0) | (last >= end ? last_element : 0);
+                lo = first > 0 ? first - 1 : 0;
+                hi = std::min(last + 1, end);
+            } else {
+                lo = end;
+                hi = 0;
+            }
+            edges[2 * pos + step] = edge;
+            METRIC(metrics.phase_done(step, edge != 0 || lo < hi);)
+
+            if (step == 0) {
+                phases[pos]++; // Ready for the next phase
+                notify_all(&phases[pos], state.policy);
+
+                // Wait my neighbours to be ready
+                wait_neighbours(thid, nw, state);
+                METRIC(metrics.spin_done();)
+            }
+        }
+
+        sync.wait(thid);
+        METRIC(metrics.barrier_done();)
+        swaps[pos] = 0;
+    }
+}
+
+/**
+ * @brief The business logic of the temporally blocked worker: every iteration applies depth phases.
+ *        First the worker computes the trapezoid of its chunk, whose edges shared with a neighbour
+ *        shrink by one pair per phase, then, when the neighbours are done, it fills the triangle
+ *        on its right boundary.
+ *
+ * @tparam T the vector pointer type
+ * @param thid the thread identifier
+ * @param v the pointer to the vector
+ * @param end the end position (included), at least 2 * depth - 1
+ * @param offset if false, the odd positions in the pointer are odd positions in the whole array,
+ *               if true, the odd positions in the pointer are even positions in the whole array.
+ * @param depth the number of phases per iteration (even)
+ * @param state the state shared by the threads of the run
+ */
+template <typename T>
+void temporal_thread_body(int thid, T const v, size_t const end, bool const offset, int const nw,
+                          unsigned const depth,
+                          native_state &state) {
+    auto const cache_padding = state.cache_padding;
+    auto const pos = thid * cache_padding; // Cache-aware position in phases and swaps array
+    auto &phases = state.phases;
+    auto &swaps  = state.swaps;
+    auto &sync   = *state.sync;
+    auto const has_left_neigh = thid > 0, has_right_neigh = thid < nw - 1;
+    short const phase = !offset; // Every iteration starts with an odd phase
+    METRIC(auto &metrics = state.metrics[thid]; metrics.start();)
+    unsigned block_swaps;
+
+    while (!state.finished) {
+        block_swaps = temporal_block(v, phase, end, depth, has_left_neigh, has_right_neigh);
+        swaps[pos] |= block_swaps;
+        METRIC(metrics.phase_done(0, block_swaps);)
+
+        phases[pos]++; // Trapezoid done
+        notify_all(&phases[pos], state.policy);
+
+        // Wait my neighbours to be ready
+        wait_neighbours(thid, nw, state);
+        METRIC(metrics.spin_done();)
+
+        block_swaps = has_right_neigh ? temporal_triangle(v, phase, end, depth) : 0;
+        swaps[pos] |= block_swaps;
+        METRIC(metrics.phase_done(1, block_swaps);)
+
+        sync.wait(thid);
+        METRIC(metrics.barrier_done();)
+        swaps[pos] = 0;
+    }
+}
+
+/**
+ * @brief It merges two adjacent sorted blocks, keeping only the lower or the upper part.
+ *
+ * @tparam T the vector pointer type
+ * @param left the pointer to the left block
+ * @param left_len the length of the left block
+ * @param right the pointer to the right block
+ * @param right_len the length of the right block
+ * @param out the output buffer, long as the kept part
+ * @param keep_low if true, the left_len smallest elements are kept,
+ *                 if false, the right_len largest elements are kept.
+ */
+template <typename T>
+void merge_split(T const * const left, size_t const left_len, T const * const right, size_t const right_len,
+                 T * const out, bool const keep_low) {
+    if (keep_low) {
+        size_t i = 0, j = 0;
+        for (size_t k = 0; k < left_len; ++k)
+            out[k] = (j == right_len || left[i] <= right[j]) ? left[i++] : right[j++];
+    } else {
+        size_t i = left_len, j = right_len;
+        for (size_t k = right_len; k > 0; --k)
+            out[k - 1] = (i == 0 || right[j - 1] >= left[i - 1]) ? right[--j] : left[--i];
+    }
+}
+
+/**
+ * @brief The business logic of the block worker: it sorts its block, then it runs
+ *        the odd-even transposition at block granularity, merge-splitting with the neighbours.
+ *        In the first round of an iteration the pairs are (0, 1), (2, 3)..., in the second one (1, 2), (3, 4)...
+ *
+ * @tparam T the vector pointer type
+ * @param thid the thread identifier
+ * @param blocks the block boundaries: the block of the thread i is [blocks[i], blocks[i + 1])
+ * @param nw the number of workers
+ * @param state the state shared by the threads of the run
+ */
+template <typename T>
+void block_thread_body(int thid, std::vector<T *> const &blocks, int const nw,
+                       native_state &state) {
+    auto const cache_padding = state.cache_padding;
+    auto const pos = thid * cache_padding; // Cache-aware position in phases and swaps array
+    auto &phases = state.phases;
+    auto &swaps  = state.swaps;
+    auto &sync   = *state.sync;
+    T * const v = blocks[thid];
+    size_t const len = blocks[thid + 1] - v;
+
+    METRIC(auto &metrics = state.metrics[thid]; metrics.start();)
+
+    std::sort(v, v + len);
+    std::vector<T> buffer(len);
+    phases[pos]++; // Block sorted, the partners can read it
+    notify_all(&phases[pos], state.policy);
+    METRIC(metrics.phase_done(0, 0);)
+
+    while (!state.finished) {
+        for (int round = 0; round < 2; ++round) {
+            auto const partner = thid % 2 == round ? thid + 1 : thid - 1;
+            if (partner < 0 || partner >= nw) {
+                phases[pos] += 2; // Keep the same progress of the paired workers
+                notify_all(&phases[pos], state.policy);
+                continue;
+            }
+            auto const partner_pos = partner * cache_padding;
+            auto const left = std::min(thid, partner), right = left + 1;
+            size_t const left_len = blocks[right] - blocks[left], right_len = blocks[right + 1] - blocks[right];
+
+            // Wait my partner to write back its block
+            wait_until(&phases[partner_pos], [&](unsigned value) { return value >= phases[pos]; }, state.policy);
+            METRIC(metrics.spin_done();)
+
+            // The blocks are sorted: they are already split if the boundary is in order
+            auto const changed = blocks[right][-1] > blocks[right][0];
+            if (changed)
+                merge_split<T>(blocks[left], left_len, blocks[right], right_len, buffer.data(), thid == left);
+            METRIC(metrics.phase_done(round, 0);)
+
+            phases[pos]++; // Done reading the partner block
+            notify_all(&phases[pos], state.policy);
+
+            // Wait my partner to read my block
+            wait_until(&phases[partner_pos], [&](unsigned value) { return value >= phases[pos]; }, state.policy);
+            METRIC(metrics.spin_done();)
+
+            if (changed) {
+                std::copy(buffer.begin(), buffer.end(), v);
+                swaps[pos] = 1;
+            }
+            METRIC(metrics.phase_done(round, changed);)
+
+            phases[pos]++; // Block written back
+            notify_all(&phases[pos], state.policy);
+        }
+
+        sync.wait(thid);
+        METRIC(metrics.barrier_done();)
+        swaps[pos] = 0;
+    }
+}
+
+/**
+ * @brief The business logic of the controller: checks in real time if there are swaps,
+ *        to keep the workers running or to stop them.
+ *
+ * @tparam State the shared state type (see thread_body)
+ * @param state the state shared by the threads of the run
+ * @param id the controller identifier in the barrier (the last one)
+ */
+template <typename State>
+void controller_body(State &state, int const id) {
+    auto const cache_padding = state.cache_padding;
+    auto const &swaps = state.swaps;
+    auto &sync = *state.sync;
+
+    while (true) {
+        unsigned local_swaps = 0;
+        unsigned checks = 0;
+
+        // While there are no swaps and some worker is still running...
+        while (!local_swaps && sync.read() > 1) {
+            for (size_t i = 0; i < swaps.size(); i += cache_padding)
+                local_swaps |= swaps[i];
+            if (state.policy != wait_policy::spin)
+                relax(state.policy, checks);
+        }
+
+        // If there are no swaps, search again (I might have missed the last one)
+        size_t i = 0;
+        while (!local_swaps && i < swaps.size()) {
+            local_swaps |= swaps[i];
+            i += cache_padding;
+        }
+
+        // No swaps, end of the computation
+        if (!local_swaps) {
+            state.finished = true;
+            for (size_t i = 0; i < state.parking.size(); i += cache_padding) {
+                wait_until(&state.parking[i], [](unsigned value) { return value != worker_parking; }, state.policy);
+                unsigned expected = worker_parked;
+                if (!__atomic_compare_exchange_n(&state.parking[i], &expected, worker_waking, false,
+                                                 __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                    continue;
+                sync.join(static_cast<int>(i / cache_padding)); // The barrier ends the run with everybody
+                __atomic_store_n(&state.parking[i], worker_running, __ATOMIC_RELEASE);
+                notify_all(&state.parking[i], wait_policy::block);
+            }
+            sync.dec(id);
+            return;
+        }
+
+        sync.wait(id);
+    }
+}
+
+#endif // ODD_EVEN_SORT_NATIVE_HPP
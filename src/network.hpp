@@ -0,0 +1,195 @@
+/**
+ * @file   network.hpp
+ * @brief  It contains the sorting networks for the small arrays: the odd-even transposition and the Batcher
+ *         odd-even merge networks, generated at compile time and fully unrolled
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_NETWORK_HPP
+#define ODD_EVEN_SORT_NETWORK_HPP
+
+#include <cstddef>
+#include <initializer_list>
+#include <utility> // std::index_sequence
+
+// The longest array with a network: the longer ones are sorted by the engines
+size_t constexpr network_max_length = 32;
+
+/**
+ * The networks
+ */
+enum class network_kind {
+    transposition, // n phases of the odd-even transposition: n (n - 1) / 2 comparators
+    batcher        // Batcher odd-even merge sort: O(n log^2 n) comparators
+};
+
+/**
+ * @brief It generates the comparators of a network, in order.
+ *
+ * @tparam Sink the comparator consumer type
+ * @param kind the network
+ * @param n the number of elements
+ * @param sink it takes the two indexes of every comparator, the lower first
+ */
+template <typename Sink>
+constexpr void generate_network(network_kind const kind, size_t const n, Sink &sink) {
+    if (kind == network_kind::transposition) {
+        for (size_t phase = 0; phase < n; ++phase)
+            for (size_t i = 1 - phase % 2; i + 1 < n; i += 2) // Odd phase first
+                sink.add(i, i + 1);
+        return;
+    }
+
+    // The network of the next power of two: the comparators with a missing element are dropped,
+    // as if the missing elements were larger than everything
+    size_t size = 1;
+    while (size < n)
+        size *= 2;
+    for (size_t p = 1; p < size; p *= 2)
+        for (size_t k = p; k >= 1; k /= 2)
+            for (size_t j = k % p; j + k < size; j += 2 * k)
+                for (size_t i = 0; i < k && i + j + k < size; ++i)
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p) && i + j + k < n)
+                        sink.add(i + j, i + j + k);
+}
+
+/**
+ * It counts the comparators of a network
+ */
+struct network_counter {
+    size_t size = 0;
+
+    constexpr void add(size_t, size_t) {
+        ++size;
+    }
+};
+
+/**
+ * The comparators of a network
+ *
+ * @tparam Capacity the number of comparators (at least one, for the arrays)
+ */
+template <size_t Capacity>
+struct network_table {
+    size_t size = 0;
+    unsigned short low[Capacity] = {};
+    unsigned short high[Capacity] = {};
+
+    constexpr void add(size_t const i, size_t const j) {
+        low[size]  = static_cast<unsigned short>(i);
+        high[size] = static_cast<unsigned short>(j);
+        ++size;
+    }
+};
+
+/**
+ * @return the number of comparators of a network
+ */
+constexpr size_t network_size(network_kind const kind, size_t const n) {
+    network_counter counter;
+    generate_network(kind, n, counter);
+    return counter.size;
+}
+
+/**
+ * @return the network with less comparators on n elements
+ */
+constexpr network_kind best_network(size_t const n) {
+    return network_size(network_kind::batcher, n) < network_size(network_kind::transposition, n)
+           ? network_kind::batcher : network_kind::transposition;
+}
+
+/**
+ * @return the comparators of a network
+ */
+template <size_t Capacity>
+constexpr network_table<Capacity> build_network(network_kind const kind, size_t const n) {
+    network_table<Capacity> table;
+    generate_network(kind, n, table);
+    return table;
+}
+
+/**
+ * A network on N elements, built at compile time
+ *
+ * @tparam Kind the network
+ * @tparam N the number of elements
+ */
+template <network_kind Kind, size_t N>
+struct sorting_network {
+    static size_t constexpr size = network_size(Kind, N);
+    static size_t constexpr capacity = size > 0 ? size : 1;
+    static constexpr network_table<capacity> table = build_network<capacity>(Kind, N);
+};
+
+template <network_kind Kind, size_t N>
+constexpr network_table<sorting_network<Kind, N>::capacity> sorting_network<Kind, N>::table;
+
+/**
+ * @brief It sorts a pair, without branches.
+ *
+ * @tparam T the element type
+ * @param a the first element, set to the lower one
+ * @param b the second element, set to the higher one
+ */
+template <typename T>
+inline void compare_exchange(T &a, T &b) {
+    T const low  = b < a ? b : a;
+    T const high = b < a ? a : b;
+    a = low;
+    b = high;
+}
+
+/**
+ * @brief It applies the comparators of a network, unrolled: the indexes are constants,
+ *        so the elements stay in registers and every comparator is a min and a max.
+ */
+template <network_kind Kind, size_t N, typename T, size_t... I>
+inline void apply_network(T * const x, std::index_sequence<I...>) {
+    using network = sorting_network<Kind, N>;
+    (void) x; // Unused with no comparators
+    (void) std::initializer_list<int>{(compare_exchange(x[network::table.low[I]], x[network::table.high[I]]), 0)...};
+}
+
+/**
+ * @brief It sorts N elements with a network: no loop and no termination check.
+ *
+ * @tparam Kind the network
+ * @tparam N the number of elements
+ * @tparam T the element type
+ * @param v the pointer to the elements
+ */
+template <network_kind Kind, size_t N, typename T>
+void network_sort(T * const v) {
+    T x[N > 0 ? N : 1];
+    for (size_t i = 0; i < N; ++i)
+        x[i] = v[i];
+    apply_network<Kind, N>(x, std::make_index_sequence<sorting_network<Kind, N>::size>{});
+    for (size_t i = 0; i < N; ++i)
+        v[i] = x[i];
+}
+
+/**
+ * @brief It sorts a small array with the network of its length, chosen at run time among the compiled ones.
+ */
+template <typename T, size_t... N>
+void network_sort(T * const v, size_t const n, std::index_sequence<N...>) {
+    using sorter = void (*)(T *);
+    static sorter const networks[] = {&network_sort<best_network(N), N, T>...};
+    networks[n](v);
+}
+
+/**
+ * @brief It sorts a small array with the network of its length, the one with less comparators.
+ *
+ * @tparam T the element type
+ * @param v the pointer to the elements
+ * @param n the number of elements, at most network_max_length
+ */
+template <typename T>
+void network_sort(T * const v, size_t const n) {
+    network_sort(v, n, std::make_index_sequence<network_max_length + 1>{});
+}
+
+#endif // ODD_EVEN_SORT_NETWORK_HPP
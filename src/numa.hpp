@@ -0,0 +1,290 @@
+/**
+ * @file   numa.hpp
+ * @brief  It contains the NUMA mode: every chunk is allocated on the node of its worker,
+ *         and the workers exchange only the boundary elements
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_NUMA_HPP
+#define ODD_EVEN_SORT_NUMA_HPP
+
+#include <algorithm> // std::upper_bound, std::is_sorted, std::copy, std::find, std::remove
+#include <cstdlib>   // strtoul
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <kernel.hpp>
+#include <oddeven.hpp>
+#include <placement.hpp>
+#include <util.hpp>
+
+/**
+ * @brief It parses a CPU list of the kernel, like "0-3,8,10-11".
+ *
+ * @param list the list
+ * @return the CPUs
+ */
+inline std::vector<unsigned> parse_cpu_list(std::string const &list) {
+    std::vector<unsigned> cpus;
+    std::stringstream stream{list};
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (item.empty() || item == "\n")
+            continue;
+        auto const dash = item.find('-');
+        unsigned const first = strtoul(item.c_str(), nullptr, 10);
+        unsigned const last  = dash == std::string::npos ? first : strtoul(item.c_str() + dash + 1, nullptr, 10);
+        for (auto cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+/**
+ * @brief It reads the NUMA nodes from /sys/devices/system/node, keeping the CPUs I'm allowed to run on.
+ *
+ * @return the CPUs of every node with some of them: a single node if the machine isn't NUMA (or it's unknown)
+ */
+inline std::vector<std::vector<unsigned>> numa_nodes() {
+    std::vector<std::vector<unsigned>> nodes;
+    std::vector<unsigned> all;
+#ifdef LINUX_MACHINE
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    auto const known = sched_getaffinity(0, sizeof(cpu_set_t), &allowed) == 0;
+
+    // The node numbers can have holes (offline nodes): stop after a run of missing ones
+    for (int node = 0, missing = 0; missing < 64; ++node) {
+        std::ifstream file{"/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"};
+        std::string list;
+        if (!std::getline(file, list)) {
+            ++missing;
+            continue;
+        }
+        missing = 0;
+        std::vector<unsigned> cpus;
+        for (auto cpu : parse_cpu_list(list))
+            if (!known || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)))
+                cpus.push_back(cpu);
+        if (!cpus.empty())
+            nodes.push_back(cpus);
+    }
+    if (!nodes.empty())
+        return nodes;
+
+    for (unsigned cpu = 0; known && cpu < CPU_SETSIZE; ++cpu)
+        if (CPU_ISSET(cpu, &allowed))
+            all.push_back(cpu);
+#endif
+    for (unsigned cpu = 0; all.empty() && cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu)
+        all.push_back(cpu);
+    nodes.push_back(all);
+    return nodes;
+}
+
+/**
+ * @brief It places the workers on the nodes: consecutive workers on the same node, so only the chunks on
+ *        the node boundaries exchange elements between two nodes. In a node the CPUs follow the placement
+ *        policy, and the CPU of the controller is left to it.
+ *
+ * @param nw the number of workers
+ * @param nodes the CPUs of every node (see numa_nodes)
+ * @param policy the placement policy
+ * @return the CPU of every worker
+ */
+inline std::vector<unsigned> numa_placement(int const nw, std::vector<std::vector<unsigned>> const &nodes,
+                                            placement const policy) {
+    auto const order = placement_order(policy);
+    auto const controller = place_threads(0, policy).controller;
+    std::vector<unsigned> cpus(nw);
+    auto const count = static_cast<int>(nodes.size());
+    for (int node = 0, w = 0; node < count; ++node) {
+        std::vector<unsigned> candidates;
+        for (auto cpu : order)
+            if (std::find(nodes[node].begin(), nodes[node].end(), cpu) != nodes[node].end())
+                candidates.push_back(cpu);
+        if (candidates.size() > 1)
+            candidates.erase(std::remove(candidates.begin(), candidates.end(), controller), candidates.end());
+        if (candidates.empty())
+            candidates = nodes[node];
+        for (size_t j = 0; w < (node + 1) * nw / count; ++w, ++j)
+            cpus[w] = candidates[j % candidates.size()];
+    }
+    return cpus;
+}
+
+/**
+ * The chunk of a NUMA worker: its elements, followed by a copy of the first element of the next chunk
+ * (the boundary element, owned by the next worker).
+ *
+ * @tparam T the element type
+ */
+template <typename T>
+struct numa_chunk {
+    T *local;
+    T *next; // The first element of the next chunk, null for the last worker
+};
+
+/**
+ * @brief It performs an odd or an even sorting phase on a NUMA chunk: when the phase includes the pair
+ *        on the boundary, the boundary element is read from the next chunk before, and written back after.
+ *        In that phase the next worker doesn't touch it, and the neighbours handshake separates the phases.
+ *
+ * @tparam T the element type
+ * @param c the chunk
+ * @param phase the phase (odd or even)
+ * @param end the end of the chunk (the boundary element)
+ * @return the number of swaps
+ */
+template <typename T>
+unsigned odd_even_sort(numa_chunk<T> const &c, short const phase, size_t const end) {
+    if (c.next == nullptr || end <= static_cast<size_t>(phase) || (end - phase) % 2 == 0)
+        return odd_even_sort(c.local, phase, end);
+    c.local[end] = *c.next;
+    auto const swaps = odd_even_sort(c.local, phase, end);
+    *c.next = c.local[end];
+    return swaps;
+}
+
+namespace oddeven {
+
+/**
+ * An array split in chunks, every one allocated and first-touched on the node of the worker that sorts it.
+ * The sorted result stays segmented: it can be read in place, or gathered in a contiguous array.
+ *
+ * @tparam T the element type
+ */
+template <typename T>
+class segmented_vector {
+public:
+    /**
+     * @brief It creates the chunks in parallel, every worker pinned on its CPU before allocating.
+     *
+     * @tparam F the generator type
+     * @param n the number of elements
+     * @param p the policy of the sort (the number of workers, the pinning)
+     * @param value it takes an index and returns the value of its element
+     */
+    template <typename F>
+    segmented_vector(size_t const n, policy const &p, F value)
+            : nodes{numa_nodes()},
+              starts{detail::chunk_starts(std::max<size_t>(n, 1), detail::transposition_workers(n, p))},
+              cpus{numa_placement(static_cast<int>(starts.size()) - 1, nodes, p.placement)}, chunks(cpus.size()) {
+        starts.back() = n;
+        std::vector<std::thread> threads;
+        for (size_t w = 0; w < chunks.size(); ++w) {
+            threads.emplace_back([&, w] {
+                if (p.pinning)
+                    detail::pin(pthread_self(), cpus[w]); // Before the allocation and the first touch
+                auto const last = std::min(n, starts[w + 1] + 1); // With the copy of the boundary element
+                chunks[w].resize(last - starts[w]);
+                for (size_t i = starts[w]; i < last; ++i)
+                    chunks[w][i - starts[w]] = value(i);
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+    }
+
+    /**
+     * @return the number of elements
+     */
+    size_t size() const {
+        return starts.back();
+    }
+
+    /**
+     * @return the number of chunks (the workers of the sort)
+     */
+    size_t segments() const {
+        return chunks.size();
+    }
+
+    /**
+     * @return the number of NUMA nodes
+     */
+    size_t numa_node_count() const {
+        return nodes.size();
+    }
+
+    /**
+     * @param i the index of an element
+     * @return the element
+     */
+    T const &operator[](size_t const i) const {
+        size_t const w = std::upper_bound(starts.begin(), starts.end(), i) - starts.begin() - 1;
+        return chunks[w][i - starts[w]];
+    }
+
+    /**
+     * @brief It copies the elements in a contiguous array.
+     *
+     * @param out the array, of size() elements
+     */
+    void gather(T * const out) const {
+        for (size_t w = 0; w < chunks.size(); ++w)
+            std::copy(chunks[w].begin(), chunks[w].begin() + (starts[w + 1] - starts[w]), out + starts[w]);
+    }
+
+    /**
+     * @return true if the elements are sorted
+     */
+    bool is_sorted() const {
+        for (size_t w = 0; w < chunks.size(); ++w) {
+            auto const last = chunks[w].begin() + (starts[w + 1] - starts[w]);
+            if (!std::is_sorted(chunks[w].begin(), last)
+                || (w > 0 && chunks[w][0] < chunks[w - 1][starts[w] - starts[w - 1] - 1]))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    template <typename U>
+    friend void sort(segmented_vector<U> &data, policy const &p);
+
+    std::vector<std::vector<unsigned>> nodes;
+    std::vector<size_t> starts;
+    std::vector<unsigned> cpus;                  // The CPU of every worker
+    std::vector<untouched_vector<T>> chunks;
+};
+
+/**
+ * @brief It sorts a segmented vector with the transposition engine, a worker per chunk on the CPU that created it
+ *        (a single chunk is sorted by the calling thread).
+ *        The chunks are sorted phase by phase: temporal blocking and dirty-range tracking are not used.
+ *
+ * @tparam T the element type
+ * @param data the segmented vector
+ * @param p the policy, that must be valid (see validate): the one of the creation
+ */
+template <typename T>
+void sort(segmented_vector<T> &data, policy const &p) {
+    auto const nw = static_cast<int>(data.segments());
+    if (data.size() < 2)
+        return;
+    if (nw == 1) {
+        sequential_sort(data.chunks[0].data(), data.size(), p.depth);
+        return;
+    }
+
+    detail::run(nw, p, [&](native_state &state) {
+        std::vector<std::unique_ptr<std::thread>> workers;
+        workers.reserve(nw);
+        for (int i = 0; i < nw; ++i) {
+            numa_chunk<T> const chunk{data.chunks[i].data(), i < nw - 1 ? data.chunks[i + 1].data() : nullptr};
+            auto const end = i < nw - 1 ? data.starts[i + 1] - data.starts[i] : data.size() - 1 - data.starts[i];
+            workers.push_back(std::make_unique<std::thread>(
+                    thread_body<numa_chunk<T>>, i, chunk, end, data.starts[i] % 2, nw, std::ref(state)));
+        }
+        return workers;
+    }, &data.cpus);
+}
+
+} // namespace oddeven
+
+#endif // ODD_EVEN_SORT_NUMA_HPP
@@ -0,0 +1,420 @@
+/**
+ * @file   oddeven.hpp
+ * @brief  It contains the library entry point: the odd-even sort of caller-owned contiguous memory
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_ODDEVEN_HPP
+#define ODD_EVEN_SORT_ODDEVEN_HPP
+
+#include <algorithm>  // std::min
+#include <array>
+#include <cmath>      // for ceil
+#include <functional> // std::ref, std::cref
+#include <memory>     // Smart pointers
+#include <string>
+#include <thread>
+#include <utility>    // std::move
+#include <vector>
+
+#include <barrier.hpp>
+#include <batcher.hpp>
+#include <metrics.hpp>
+#include <columns.hpp>
+#include <native.hpp>
+#include <network.hpp>
+#include <placement.hpp>
+#include <sequential.hpp>
+#include <util.hpp>
+#include <wait.hpp>
+
+namespace oddeven {
+
+/**
+ * The available engines
+ */
+enum class engine {
+    sequential,    // The calling thread, phase by phase or temporally blocked
+    transposition, // The native threads running the element-level odd-even phases
+    block,         // The native threads running the block merge-split
+    batcher        // The native threads running the stages of the Batcher odd-even merge network
+};
+
+/**
+ * How to sort: the defaults are the ones of the par executable
+ */
+struct policy {
+    oddeven::engine engine  = oddeven::engine::transposition;
+    int nw                  = default_workers(); // From the allowed CPUs and the CPU quota
+    unsigned depth          = 0;         // Temporal blocking depth (zero: phase by phase)
+    bool dirty              = false;     // Dirty-range tracking (transposition only)
+    unsigned rebalance      = 0;         // Iterations between the repartitions by the worker speed (zero: never)
+    unsigned park           = 0;         // Iterations without swaps around a worker before it parks (zero: never)
+    size_t network          = network_max_length; // The arrays up to this length are sorted by a network (zero: never)
+    size_t cache_line       = 64;        // Padding between the progress counters of two workers, in bytes
+    bool pinning            = true;      // Pin the controller and the workers
+    ::placement placement   = ::placement::compact; // Where to pin them
+    std::string barrier     = "central"; // "central", "tree" or "dissemination"
+    std::string wait        = "auto";    // "auto", "spin", "backoff", "yield" or "block"
+    std::vector<worker_metrics> *metrics = nullptr; // Filled with the metrics of the workers (-DMETRICS builds only)
+};
+
+/**
+ * @brief It checks a policy.
+ *
+ * @param p the policy
+ * @return the error message, empty if the policy is valid
+ */
+inline std::string validate(policy const &p) {
+    wait_policy dummy;
+    if (p.nw < 1)
+        return "nw must be greater than zero";
+    if (p.network > network_max_length)
+        return "the networks are compiled up to " + std::to_string(network_max_length) + " elements";
+    if (p.depth % 2 != 0)
+        return "the temporal blocking depth must be even: the termination check needs an odd and an even phase";
+    if (p.cache_line < 1)
+        return "the cache-line size must be greater than zero";
+    if (p.barrier != "central" && p.barrier != "tree" && p.barrier != "dissemination")
+        return "unknown barrier " + p.barrier;
+    if (!parse_wait_policy(p.wait, 1, 1, dummy))
+        return "unknown wait policy " + p.wait;
+    if (p.engine == engine::batcher && (p.dirty || p.depth > 0 || p.rebalance > 0 || p.park > 0))
+        return "the Batcher network has fixed stages: no dirty ranges, temporal blocking, repartition or parking";
+    if (p.rebalance > 0 && (p.engine == engine::block || p.dirty || p.depth > 0))
+        return "the repartition works with the transposition engine, phase by phase";
+    if (p.park > 0 && (p.engine == engine::block || p.dirty || p.depth > 0 || p.rebalance > 0))
+        return "the parking works with the transposition engine, phase by phase, on fixed chunks";
+    if (p.park > 0 && p.barrier != "central")
+        return "the parking needs the central barrier, the only one that the workers can leave";
+    return "";
+}
+
+namespace detail {
+
+/**
+ * @brief It pins a thread on a CPU, best effort: an unpinned thread still works.
+ *
+ * @param thread the native handle of the thread
+ * @param cpu the CPU
+ */
+inline void pin(std::thread::native_handle_type const thread, unsigned const cpu) {
+#ifdef LINUX_MACHINE
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuset);
+#else
+    (void) thread;
+    (void) cpu;
+#endif
+}
+
+/**
+ * @brief It splits n elements among the workers, as the engines do (the boundary elements aside).
+ *
+ * @param n the number of elements
+ * @param nw the number of workers
+ * @return the first element of every worker, and n
+ */
+inline std::vector<size_t> chunk_starts(size_t const n, int const nw) {
+    size_t const chunk_len = (n - 1) / nw;
+    long remaining = static_cast<long>((n - 1) % nw);
+    std::vector<size_t> starts(nw + 1);
+    starts[nw] = n;
+    for (int i = 1; i < nw; ++i, --remaining)
+        starts[i] = starts[i - 1] + chunk_len + (remaining > 0);
+    return starts;
+}
+
+/**
+ * @brief It chooses the workers of the element-level engines: at least a pair per worker.
+ *
+ * @param n the number of elements
+ * @param p the policy
+ * @return the number of workers
+ */
+inline int transposition_workers(size_t const n, policy const &p) {
+    return p.engine == engine::sequential || n < 2 ? 1 : static_cast<int>(std::min<size_t>(p.nw, n - 1));
+}
+
+/**
+ * @brief It creates the state of a run of the native threads.
+ *
+ * @param nw the number of workers
+ * @param p the policy
+ * @return the state
+ */
+inline native_state make_state(int const nw, policy const &p) {
+    // Busy waiting collapses when the threads are more than the cores: auto sleeps in that case
+    wait_policy wait = wait_policy::spin;
+    parse_wait_policy(p.wait, nw + 1, effective_cpus(), wait);
+
+    short const cache_padding = ceil(static_cast<double>(p.cache_line) / sizeof(unsigned));
+    return native_state(nw, cache_padding, wait, make_barrier(p.barrier, nw + 1, wait)); // + 1 for the controller
+}
+
+/**
+ * @brief It creates the controller, lets spawn create the workers, pins the threads and joins them.
+ *
+ * @tparam Spawn the worker factory type
+ * @param nw the number of workers
+ * @param p the policy
+ * @param spawn it takes the shared state and returns the workers
+ * @param cpus the CPU of every worker (null: the placement of the policy)
+ */
+template <typename Spawn>
+void run(int const nw, policy const &p, Spawn spawn, std::vector<unsigned> const *cpus = nullptr) {
+    auto state = make_state(nw, p);
+
+    std::thread controller(controller_body<native_state>, std::ref(state), nw);
+    std::vector<std::unique_ptr<std::thread>> workers = spawn(state);
+
+    // Thread pinning
+    if (p.pinning) {
+        auto const where = place_threads(nw, p.placement);
+        pin(controller.native_handle(), where.controller);
+        for (int i = 0; i < nw; ++i)
+            pin(workers[i]->native_handle(), cpus ? (*cpus)[i] : where.workers[i]);
+    }
+
+    controller.join();
+    for (auto &thread : workers)
+        thread->join();
+
+    METRIC(if (p.metrics) *p.metrics = std::move(state.metrics);)
+}
+
+/**
+ * @brief It fits the temporal blocking depth to the chunks: the triangles on their boundaries must not overlap.
+ *
+ * @param depth the requested depth
+ * @param n the number of elements
+ * @param nw the number of workers
+ * @return the depth (zero: phase by phase)
+ */
+inline unsigned fit_depth(unsigned depth, size_t const n, int const nw) {
+    size_t const chunk_len = (n - 1) / nw;
+    if (depth > 0 && nw > 1)
+        depth = std::min<unsigned>(depth, (chunk_len + 1) / 2) & ~1u;
+    return depth < 2 ? 0 : depth; // Chunks too small, phase by phase
+}
+
+/**
+ * @brief It runs a worker of the transposition engine on its chunk, with the body chosen by the policy.
+ *
+ * @tparam V the vector pointer type (a pointer or a column view)
+ * @param i the worker identifier
+ * @param nw the number of workers
+ * @param first the pointer to the first element
+ * @param n the number of elements
+ * @param depth the temporal blocking depth (see fit_depth)
+ * @param p the policy
+ * @param state the state shared by the threads of the run
+ */
+template <typename V>
+void transposition_worker(int const i, int const nw, V const first, size_t const n, unsigned const depth,
+                          policy const &p, native_state &state) {
+    auto starts = chunk_starts(n, nw);
+    auto const offset = starts[i];
+    auto const end = (i < nw - 1 ? starts[i + 1] : n - 1) - offset; // The boundary element included
+    if (p.rebalance > 0) {
+        starts[nw] = n - 1; // The last element
+        adaptive_thread_body<V>(i, first, std::move(starts), nw, p.rebalance, state);
+    } else if (p.dirty) {
+        dirty_thread_body<V>(i, first + offset, end, offset % 2, nw, state);
+    } else if (p.park > 0) {
+        parking_thread_body<V>(i, first + offset, end, offset % 2, nw, p.park, state);
+    } else if (depth > 0) {
+        temporal_thread_body<V>(i, first + offset, end, offset % 2, nw, depth, state);
+    } else {
+        thread_body<V>(i, first + offset, end, offset % 2, nw, state);
+    }
+}
+
+/**
+ * @brief It sorts with the element-level odd-even phases, sequentially or on the native threads.
+ *
+ * @tparam V the vector pointer type (a pointer or a column view)
+ * @param first the pointer to the first element
+ * @param n the number of elements
+ * @param p the policy
+ */
+template <typename V>
+void sort_transposition(V const first, size_t const n, policy const &p) {
+    if (p.engine == engine::sequential) {
+        sequential_sort(first, n, p.depth);
+        return;
+    }
+
+    auto const nw = transposition_workers(n, p);
+    auto const depth = fit_depth(p.depth, n, nw);
+
+    run(nw, p, [&](native_state &state) {
+        std::vector<std::unique_ptr<std::thread>> workers;
+        workers.reserve(nw);
+        for (int i = 0; i < nw; ++i)
+            workers.push_back(std::make_unique<std::thread>(
+                    transposition_worker<V>, i, nw, first, n, depth, std::cref(p), std::ref(state)));
+        return workers;
+    });
+}
+
+/**
+ * @brief It sorts with the stages of the Batcher odd-even merge network on the native threads:
+ *        the workers synchronize on a barrier of their own after every stage, without the controller.
+ *
+ * @tparam T the element type
+ * @param first the pointer to the first element
+ * @param n the number of elements
+ * @param p the policy
+ */
+template <typename T>
+void sort_batcher(T * const first, size_t const n, policy const &p) {
+    auto const nw = static_cast<int>(std::min<size_t>(p.nw, n / 2)); // At least a pair per worker
+    auto const block = batcher_block(n, nw);
+    auto const starts = batcher_starts(n, nw, block);
+
+    wait_policy wait = wait_policy::spin;
+    parse_wait_policy(p.wait, nw, effective_cpus(), wait);
+    short const cache_padding = ceil(static_cast<double>(p.cache_line) / sizeof(unsigned));
+    native_state state(nw, cache_padding, wait, make_barrier(p.barrier, nw, wait));
+
+    std::vector<std::unique_ptr<std::thread>> workers;
+    workers.reserve(nw);
+    for (int i = 0; i < nw; ++i)
+        workers.push_back(std::make_unique<std::thread>(
+                batcher_thread_body<T>, i, first, n, std::cref(starts), block, std::ref(state)));
+
+    if (p.pinning) {
+        auto const where = place_threads(nw, p.placement);
+        for (int i = 0; i < nw; ++i)
+            pin(workers[i]->native_handle(), where.workers[i]);
+    }
+    for (auto &thread : workers)
+        thread->join();
+
+    METRIC(if (p.metrics) *p.metrics = std::move(state.metrics);)
+}
+
+} // namespace detail
+
+/**
+ * @brief It sorts [first, last) in place, creating and joining the threads inside the call.
+ *
+ * @tparam T the element type
+ * @param first the pointer to the first element
+ * @param last the pointer past the last element
+ * @param p the policy, that must be valid (see validate)
+ */
+template <typename T>
+void sort(T * const first, T * const last, policy const &p = policy{}) {
+    size_t const n = last - first;
+    if (n < 2)
+        return;
+
+    if (n <= p.network) { // Too small for the threads, and the network has no termination check
+        network_sort(first, n);
+        return;
+    }
+
+    if (p.engine == engine::batcher) {
+        detail::sort_batcher(first, n, p);
+        return;
+    }
+
+    if (p.engine != engine::block) {
+        detail::sort_transposition(first, n, p);
+        return;
+    }
+
+    auto const nw = static_cast<int>(std::min<size_t>(p.nw, n));
+
+    // The blocks don't share the boundary element: the last one also takes the last element
+    auto const starts = detail::chunk_starts(n, nw);
+    std::vector<T *> blocks(nw + 1);
+    for (int i = 0; i <= nw; ++i)
+        blocks[i] = first + starts[i];
+
+    detail::run(nw, p, [&](native_state &state) {
+        std::vector<std::unique_ptr<std::thread>> workers;
+        workers.reserve(nw);
+        for (int i = 0; i < nw; ++i)
+            workers.push_back(std::make_unique<std::thread>(
+                    block_thread_body<T>, i, std::cref(blocks), nw, std::ref(state)));
+        return workers;
+    });
+}
+
+/**
+ * @brief It sorts an array of a length known at compile time with the network with less comparators,
+ *        unrolled: no threads, no loop and no termination check.
+ *
+ * @tparam T the element type
+ * @tparam N the number of elements, at most network_max_length
+ * @param a the array
+ */
+template <typename T, size_t N>
+void sort(std::array<T, N> &a) {
+    static_assert(N <= network_max_length, "the array is too long for a network");
+    network_sort<best_network(N), N>(a.data());
+}
+
+/**
+ * @brief It sorts the rows of a table stored by columns, lexicographically by its key columns.
+ *        The block and Batcher engines need whole rows to move, so they run the transposition engine instead.
+ *
+ * @tparam K the key type
+ * @param table the view of the table
+ * @param n the number of rows
+ * @param p the policy, that must be valid (see validate)
+ */
+template <typename K>
+void sort(column_view<K> const &table, size_t const n, policy const &p = policy{}) {
+    if (n < 2)
+        return;
+    detail::sort_transposition(table, n, p);
+}
+
+/**
+ * @brief It writes [first, last) in parallel, before sorting it with the same policy:
+ *        every worker writes (first-touches) the chunk it will sort, pinned on the same CPU,
+ *        so the pages of a chunk are allocated on the NUMA node of its worker.
+ *
+ * @tparam T the element type
+ * @tparam F the generator type
+ * @param first the pointer to the first element
+ * @param last the pointer past the last element
+ * @param p the policy of the sort
+ * @param value it takes an index and returns the value of its element
+ */
+template <typename T, typename F>
+void fill(T * const first, T * const last, policy const &p, F value) {
+    size_t const n = last - first;
+    auto const nw = detail::transposition_workers(n, p); // The chunks of the sort
+    if (nw == 1) {
+        for (size_t i = 0; i < n; ++i)
+            first[i] = value(i);
+        return;
+    }
+
+    auto const starts = detail::chunk_starts(n, nw);
+    auto const where = place_threads(nw, p.placement);
+    std::vector<std::thread> workers;
+    workers.reserve(nw);
+    for (int w = 0; w < nw; ++w) {
+        workers.emplace_back([&, w] {
+            if (p.pinning)
+                detail::pin(pthread_self(), where.workers[w]); // Before the first touch
+            for (size_t i = starts[w]; i < starts[w + 1]; ++i)
+                first[i] = value(i);
+        });
+    }
+    for (auto &thread : workers)
+        thread.join();
+}
+
+} // namespace oddeven
+
+#endif // ODD_EVEN_SORT_ODDEVEN_HPP
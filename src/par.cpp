@@ -5,148 +5,267 @@
  */
 
 
-#include <algorithm>  // std::is_sorted
+#include <algorithm> // std::is_sorted
 #include <cassert>
-#include <cmath>      // for ceil
-#include <functional> // std::ref, std::cref
+#include <chrono>
 #include <iostream>
-#include <memory>     // Smart pointers
-#include <thread>
+#include <memory>    // std::unique_ptr
 #include <vector>
 
-#include <barrier.hpp>
+#include <batch.hpp>
+#include <binary.hpp>
 #include <config.hpp>
+#include <distributions.hpp>
+#include <external.hpp>
+#include <numa.hpp>
+#include <oddeven.hpp>
+#include <pool.hpp>
+#include <process.hpp>
 #include <util.hpp>
 
-short cache_padding;
-bool finished = false;
-
 /**
- * @brief It performs an odd or an even sorting phase on the array.
+ * @brief It creates the random array in chunks on the NUMA nodes of their workers, and it sorts it.
  *
- * @tparam T the vector pointer type
- * @param v the pointer to the vector
- * @param phase the phase (odd or even)
- * @param end the end of the array
- * @return the number of swaps
+ * @tparam T the element type
+ * @param n the length of the array
+ * @param seed the seed for the random generator
+ * @param d the distribution of the values
+ * @param policy how to sort
+ * @param metrics_path where to write the metrics of the workers, if the policy collects them
  */
 template <typename T>
-unsigned odd_even_sort(T * const v, short const phase, size_t const end) {
-    unsigned swaps = 0;
-    for (size_t i = phase; i < end; i += 2) {
-        auto first = v[i], second = v[i + 1];
-        auto cond = first > second;
-        v[i]     = cond ? second : first;
-        v[i + 1] = cond ? first : second;
-        if (v[i] != first)
-            swaps++;
-    }
-    return swaps;
+void sort_numa(size_t const n, unsigned const seed, distribution const &d, oddeven::policy const &policy,
+               std::string const &metrics_path) {
+    auto const min = element_traits<T>::min(), max = element_traits<T>::max();
+
+    std::vector<T> source;
+    if (d.kind != shape::uniform)
+        source = create_vector<T>(d, n, min, max, seed); // The shapes need the whole vector
+    oddeven::segmented_vector<T> v(n, policy, [&](size_t i) {
+        return source.empty() ? random_value(seed, i, min, max) : source[i];
+    });
+
+    auto const start_time = std::chrono::steady_clock::now();
+    oddeven::sort(v, policy);
+    auto const duration = elapsed_ms(start_time);
+
+    std::cout << "Time: " << duration << " ms" << std::endl;
+
+#ifdef PERF_COUNTERS
+    print_counters(*policy.metrics);
+#endif
+    if (!metrics_path.empty() && !write_metrics(metrics_path, *policy.metrics))
+        std::cout << "Error writing the metrics in " << metrics_path << std::endl;
+
+    assert(v.is_sorted());
 }
 
 /**
- * @brief The business logic of the worker.
+ * @brief It creates the random array in a shared memory segment, and it sorts it with a worker process per chunk.
  *
- * @tparam T the vector pointer type
- * @param thid the thread identifier
- * @param v the pointer to the vector
- * @param end the end position (included)
- * @param offset if false, the odd positions in the pointer are odd positions in the whole array,
- *               if true, the odd positions in the pointer are even positions in the whole array.
- * @param phases the vector of phases progress
- * @param swaps the vector of swaps
- * @param barriers the synchronization barriers
+ * @tparam T the element type
+ * @param n the length of the array
+ * @param seed the seed for the random generator
+ * @param d the distribution of the values
+ * @param policy how to sort
+ * @return false if the segment or the processes failed
  */
 template <typename T>
-void thread_body(int thid, T * const v, size_t const end, bool const offset, int const nw,
-                 std::vector<unsigned> &phases,
-                 std::vector<unsigned> &swaps,
-                 std::vector<std::unique_ptr<barrier>> const &barriers) {
-    auto iter = 0;
-    auto const pos = thid * cache_padding; // Cache-aware position in phases and swaps array
-    auto const has_left_neigh = thid > 0, has_right_neigh = thid < nw - 1;
-
-    /*
-     * I know that repeating code is bad practice, but in this case
-     * is the only way to achieve better performances.
-     * The key for the performance lies in the explicit '1' and '0' in the function call,
-     * and in the asynchronous wait for the neighbours threads.
-     */
-    if (!offset) {
-        while (!finished) {
-            swaps[pos] |= odd_even_sort(v, 1, end); // Odd phase
-
-            phases[pos]++; // Ready for the next phase
-
-            // Wait my neighbours to be ready
-            if (has_right_neigh)
-                while (phases[pos] != phases[(thid + 1) * cache_padding])
-                    __asm__("nop"); // To force the compiler to don't "optimize" this loop
-            if (has_left_neigh)
-                while (phases[pos] != phases[(thid - 1) * cache_padding])
-                    __asm__("nop");
-
-            swaps[pos] |= odd_even_sort(v, 0, end); // Even phase
-
-            barriers[iter++]->wait();
-            swaps[pos] = 0;
-        }
+bool sort_processes(size_t const n, unsigned const seed, distribution const &d, oddeven::policy const &policy) {
+    auto const min = element_traits<T>::min(), max = element_traits<T>::max();
+
+    oddeven::shared_vector<T> v;
+    auto error = v.open(n, policy);
+    if (!error.empty()) {
+        std::cout << error << std::endl;
+        return false;
+    }
+    if (d.kind == shape::uniform) {
+        oddeven::fill(v.data(), v.data() + n, policy, [=](size_t i) { return random_value(seed, i, min, max); });
     } else {
-        while (!finished) {
-            swaps[pos] |= odd_even_sort(v, 0, end); // Odd phase
+        auto const source = create_vector<T>(d, n, min, max, seed); // The shapes need the whole vector
+        oddeven::fill(v.data(), v.data() + n, policy, [&](size_t i) { return source[i]; });
+    }
+
+    auto const start_time = std::chrono::steady_clock::now();
+    error = oddeven::sort(v, policy);
+    auto const duration = elapsed_ms(start_time);
+    if (!error.empty()) {
+        std::cout << error << std::endl;
+        return false;
+    }
 
-            phases[pos]++; // Ready for the next phase
+    std::cout << "Time: " << duration << " ms" << std::endl;
 
-            // Wait my neighbours to be ready
-            if (has_right_neigh)
-                while (phases[pos] != phases[(thid + 1) * cache_padding])
-                    __asm__("nop"); // To force the compiler to don't "optimize" this loop
-            if (has_left_neigh)
-                while (phases[pos] != phases[(thid - 1) * cache_padding])
-                    __asm__("nop");
+    assert(std::is_sorted(v.data(), v.data() + n));
+    return true;
+}
 
-            swaps[pos] |= odd_even_sort(v, 1, end); // Even phase
+/**
+ * @brief It creates a stream of random arrays, and it sorts them with a persistent sorter.
+ *
+ * @tparam T the element type
+ * @param n the length of every array
+ * @param arrays the number of arrays
+ * @param seed the seed for the random generator (the array k uses seed + k)
+ * @param d the distribution of the values
+ * @param policy how to sort
+ */
+template <typename T>
+void sort_stream(size_t const n, size_t const arrays, unsigned const seed, distribution const &d,
+                 oddeven::policy const &policy) {
+    auto const min = element_traits<T>::min(), max = element_traits<T>::max();
+    std::vector<std::vector<T>> stream;
+    for (size_t k = 0; k < arrays; ++k)
+        stream.push_back(create_vector<T>(d, n, min, max, seed + k));
+
+    oddeven::sorter<T> sorter{policy}; // The threads are created before the clock starts
+    auto const start_time = std::chrono::steady_clock::now();
+    for (auto &v : stream)
+        sorter.submit(v.data(), v.data() + n);
+    sorter.wait();
+    auto const duration = elapsed_ms(start_time);
+
+    std::cout << "Time: " << duration << " ms (" << duration / arrays << " ms per array)" << std::endl;
+
+    for (auto const &v : stream)
+        assert(std::is_sorted(v.begin(), v.end()));
+}
 
-            barriers[iter++]->wait();
-            swaps[pos] = 0;
-        }
+/**
+ * @brief It creates many small random arrays, of random lengths, and it sorts them in batches.
+ *
+ * @tparam T the element type
+ * @param n the maximum length of an array
+ * @param arrays the number of arrays
+ * @param seed the seed for the random generator (the array k uses seed + k)
+ * @param d the distribution of the values
+ * @param policy how to sort
+ */
+template <typename T>
+void sort_batches(size_t const n, size_t const arrays, unsigned const seed, distribution const &d,
+                  oddeven::policy const &policy) {
+    auto const min = element_traits<T>::min(), max = element_traits<T>::max();
+    std::vector<std::vector<T>> batch;
+    std::vector<T *> pointers;
+    std::vector<size_t> lengths;
+    for (size_t k = 0; k < arrays; ++k) {
+        batch.push_back(create_vector<T>(d, random_value<size_t>(seed, k, 1, n), min, max, seed + k));
+        pointers.push_back(batch.back().data());
+        lengths.push_back(batch.back().size());
     }
+
+    auto const start_time = std::chrono::steady_clock::now();
+    oddeven::sort_batch(pointers.data(), lengths.data(), arrays, policy);
+    auto const duration = elapsed_ms(start_time);
+
+    std::cout << "Time: " << duration << " ms (" << duration / arrays << " ms per array)" << std::endl;
+
+    for (auto const &v : batch)
+        assert(std::is_sorted(v.begin(), v.end()));
 }
 
 /**
- * @brief The business logic of the controller: checks in real time if there are swaps,
- *        to keep the workers running or to stop them.
+ * @brief It sorts a binary file of elements in place, out of core, printing the progress.
  *
- * @param swaps the vector of swaps
- * @param barriers the synchronization barriers
+ * @tparam T the element type
+ * @param path the file, n raw elements
+ * @param n the number of elements
+ * @param memory the memory for the blocks, in bytes
+ * @param policy how to sort the blocks
+ * @return false if the file can't be sorted
  */
-void controller_body(std::vector<unsigned> const &swaps, std::vector<std::unique_ptr<barrier>> const &barriers) {
-    auto iter = 0;
-
-    while (true) {
-        unsigned local_swaps = 0;
-
-        // While there are no swaps and some worker is still running...
-        while (!local_swaps && barriers[iter]->read() > 1) {
-            for (size_t i = 0; i < swaps.size(); i += cache_padding)
-                local_swaps |= swaps[i];
-        }
-
-        // If there are no swaps, search again (I might have missed the last one)
-        size_t i = 0;
-        while (!local_swaps && i < swaps.size()) {
-            local_swaps |= swaps[i];
-            i += cache_padding;
-        }
-
-        // No swaps, end of the computation
-        if (!local_swaps) {
-            finished = true;
-            barriers[iter]->dec();
-            return;
-        }
-
-        barriers[iter++]->wait();
+template <typename T>
+bool sort_file(std::string const &path, size_t const n, size_t const memory, oddeven::policy const &policy) {
+    mapped_file file;
+    auto const error = file.open(path);
+    if (!error.empty() || file.size() != n * sizeof(T)) {
+        std::cout << (error.empty() ? path + " doesn't hold n elements of the type" : error) << std::endl;
+        return false;
+    }
+
+    auto const mb = [](uint64_t bytes) { return bytes / (1 << 20); };
+    auto const block = std::max<size_t>(memory / (4 * sizeof(T)), 2); // Two blocks and their merge buffers
+    auto const start_time = std::chrono::steady_clock::now();
+    auto const progress = oddeven::sort_external<T>(file, block, policy, [&](external_progress const &now) {
+        if (now.passes == 0)
+            std::cout << "Block " << now.sorted << '/' << now.blocks << " sorted";
+        else
+            std::cout << "Pass " << now.passes << ": " << now.changed << " boundaries changed";
+        std::cout << " (" << elapsed_ms(start_time) << " ms, read " << mb(now.read) << " MB, written "
+                  << mb(now.written) << " MB)" << std::endl;
+    });
+    auto const duration = elapsed_ms(start_time);
+
+    std::cout << "Time: " << duration << " ms (" << progress.blocks << " blocks, " << progress.passes
+              << " passes, read " << mb(progress.read) << " MB, written " << mb(progress.written) << " MB)"
+              << std::endl;
+
+    auto const v = static_cast<T const *>(file.data());
+    assert(std::is_sorted(v, v + n));
+    return true;
+}
+
+/**
+ * @brief It creates the random array (or table) of the element type, and it sorts it.
+ *
+ * @tparam T the element type
+ * @param n the length of the array
+ * @param seed the seed for the random generator
+ * @param keys the number of key columns (zero: a plain array)
+ * @param payloads the number of payload columns
+ * @param d the distribution of the values
+ * @param policy how to sort
+ * @param metrics_path where to write the metrics of the workers, if the policy collects them
+ * @param numa if true, every chunk is allocated on the NUMA node of its worker (plain arrays only)
+ * @param files the input, sorted in place instead of the random array, and the output
+ */
+template <typename T>
+void run(size_t const n, unsigned const seed, size_t const keys, size_t const payloads, distribution const &d,
+         oddeven::policy const &policy, std::string const &metrics_path, bool const numa, binary_files const &files) {
+    auto const min = element_traits<T>::min(), max = element_traits<T>::max();
+
+    // Create the vector: every worker writes the chunk it will sort, the same values as seq
+    untouched_vector<T> v;
+    std::unique_ptr<random_table<T>> table;
+    if (keys > 0) {
+        table = std::make_unique<random_table<T>>(n, keys, payloads, min, max, seed, d);
+    } else if (numa) {
+        sort_numa<T>(n, seed, d, policy, metrics_path);
+        return;
+    } else if (files.input.is_open()) {
+        // Sorted in place, in the mapping
+    } else if (d.kind == shape::uniform) {
+        v.resize(n);
+        oddeven::fill(v.data(), v.data() + n, policy, [=](size_t i) { return random_value(seed, i, min, max); });
+    } else {
+        auto const source = create_vector<T>(d, n, min, max, seed); // The shapes need the whole vector
+        v.resize(n);
+        oddeven::fill(v.data(), v.data() + n, policy, [&](size_t i) { return source[i]; });
+    }
+    auto const first = files.input.is_open() ? files.input.data<T>() : v.data();
+
+    auto const start_time = std::chrono::steady_clock::now();
+    if (table)
+        oddeven::sort(table->view(), n, policy);
+    else
+        oddeven::sort(first, first + n, policy);
+    auto const duration = elapsed_ms(start_time);
+
+    std::cout << "Time: " << duration << " ms" << std::endl;
+
+#ifdef PERF_COUNTERS
+    print_counters(*policy.metrics);
+#endif
+    if (!metrics_path.empty() && !write_metrics(metrics_path, *policy.metrics))
+        std::cout << "Error writing the metrics in " << metrics_path << std::endl;
+
+    assert(table ? table->is_sorted() : std::is_sorted(first, first + n));
+
+    if (!files.output.empty()) {
+        auto const error = write_binary(files.output, first, n, files.type, files.header);
+        if (!error.empty())
+            std::cout << error << std::endl;
     }
 }
 
@@ -156,17 +275,53 @@ void controller_body(std::vector<unsigned> const &swaps, std::vector<std::unique
  * @return the exit status
  */
 int main(int argc, char const *argv[]) {
+    auto const options = parse_options(argc, argv);
     if (argc < 3) {
         std::cout << "Usage is " << argv[0]
-                  << " n nw [seed] [cache-line size]" << std::endl;
+                  << " n nw [seed] [cache-line size] (nw 0: one per allowed CPU within the quota, less the controller)"
+                  << " [--engine=oddeven|block|batcher] [--temporal[=depth|auto]] [--dirty] [--rebalance[=iterations]]"
+                  << " [--park[=iterations]] [--network=length] [--stream=arrays] [--batch=arrays]"
+                  << " [--external=file (the block engine by default)] [--memory=MB]"
+                  << " [--input=file (n 0: its length)] [--map=private|shared] [--output=file] [--header]"
+                  << " [--barrier=central|tree|dissemination] [--wait=auto|spin|backoff|yield|block]"
+                  << " [--placement=" << placement_names << "]"
+                  << " [--keys=columns] [--payloads=columns] [--type=" << element_types << "]"
+                  << " [--distribution=" << distribution_names << "] [--metrics=file.json|file.csv] [--numa]"
+                  << " [--processes]" << std::endl;
         return -1;
     }
 
-    auto const n  = strtol(argv[1], nullptr, 10); // Array length
+    oddeven::policy policy;
+
+    auto const engine = get_option(options, "engine", "oddeven");
+    if (engine == "oddeven") {
+        policy.engine = oddeven::engine::transposition;
+    } else if (engine == "block") {
+        policy.engine = oddeven::engine::block;
+    } else if (engine == "batcher") {
+        policy.engine = oddeven::engine::batcher;
+    } else {
+        std::cout << "Unknown engine " << engine << std::endl;
+        return -1;
+    }
+
+    // The blocks of the external mode fill the memory: the transposition phases would be quadratic on them
+    if (options.count("external") && !options.count("engine"))
+        policy.engine = oddeven::engine::block;
+
+    auto n        = strtol(argv[1], nullptr, 10); // Array length
     auto const nw = static_cast<int>(strtol(argv[2], nullptr, 10));
 
-    if (n < 1 || nw < 1) {
-        std::cout << "n and nw must be greater than zero" << std::endl;
+    // Binary mode: the array of a file, mapped and sorted in place, and the sorted array written to a file
+    binary_files files;
+    auto const file_error = open_binary_files(options, n, files);
+    if (!file_error.empty()) {
+        std::cout << file_error << std::endl;
+        return -1;
+    }
+
+    if (n < 1 || nw < 0) {
+        std::cout << "n must be greater than zero, nw not negative" << std::endl;
         return -1;
     }
 
@@ -175,75 +330,138 @@ int main(int argc, char const *argv[]) {
         return -1;
     }
 
-    // Create the vector
-    std::vector<vec_type> v;
-    if (argc > 3)
-        v = create_random_vector<vec_type>(n, MIN, MAX, strtol(argv[3], nullptr, 10));
-    else
-        v = create_random_vector<vec_type>(n, MIN, MAX);
-    auto const ptr = v.data();
-
-    // Setting the cache_padding
+    policy.nw      = nw > 0 ? nw : default_workers();
+    policy.dirty   = options.count("dirty") > 0;
+    if (options.count("rebalance")) { // Without a period: every 16 iterations
+        auto const period = get_option(options, "rebalance", "");
+        policy.rebalance = period.empty() ? 16 : static_cast<unsigned>(strtoul(period.c_str(), nullptr, 10));
+    }
+    if (options.count("park")) { // Without a patience: after 2 quiet iterations
+        auto const patience = get_option(options, "park", "");
+        policy.park = patience.empty() ? 2 : static_cast<unsigned>(strtoul(patience.c_str(), nullptr, 10));
+    }
+    if (options.count("network")) // The longest array sorted by a network (0: none)
+        policy.network = strtoul(get_option(options, "network", "").c_str(), nullptr, 10);
+    policy.depth   = options.count("temporal") ? parse_depth(get_option(options, "temporal", "")) : 0;
+    policy.barrier = get_option(options, "barrier", "central");
+    policy.wait    = get_option(options, "wait", "auto");
     if (argc > 4)
-        cache_padding = ceil(static_cast<double>(strtol(argv[4], nullptr, 10)) / sizeof(unsigned));
-    else
-        cache_padding = 64 / sizeof(unsigned);
+        policy.cache_line = strtol(argv[4], nullptr, 10);
 
-    auto const start_time = std::chrono::system_clock::now();
+    auto const placement_name = get_option(options, "placement", "compact");
+    if (!parse_placement(placement_name, policy.placement)) {
+        std::cout << "Unknown placement " << placement_name << std::endl;
+        return -1;
+    }
 
-    std::vector<std::unique_ptr<barrier>> barriers(n); // n is an upper bound for the number of iterations
-    for (auto &elem : barriers)
-        elem = std::make_unique<barrier>(nw + 1); // + 1 for the controller
+    // Metrics of the workers, in JSON or CSV (by the extension)
+    auto const metrics_path = get_option(options, "metrics", "");
+    std::vector<worker_metrics> metrics;
+    if (!metrics_path.empty()) {
+#ifndef METRICS
+        std::cout << "The metrics are not compiled: build with -DMETRICS" << std::endl;
+        return -1;
+#endif
+        policy.metrics = &metrics;
+    }
+#ifdef PERF_COUNTERS
+    policy.metrics = &metrics; // The counters are always reported
+#endif
 
-    std::vector<unsigned> phases(nw * cache_padding, 0);
-    std::vector<unsigned> swaps(nw * cache_padding, 0);
+    auto const error = oddeven::validate(policy);
+    if (!error.empty()) {
+        std::cout << error << std::endl;
+        return -1;
+    }
 
-    std::vector<std::unique_ptr<std::thread>> workers;
-    workers.reserve(nw);
+    // Key-value mode: the rows of a table, sorted by the key columns, with the payload columns alongside
+    auto const keys     = strtoul(get_option(options, "keys", "0").c_str(), nullptr, 10);
+    auto const payloads = strtoul(get_option(options, "payloads", "0").c_str(), nullptr, 10);
+    if (keys > max_key_columns || payloads > max_payload_columns || (keys == 0 && payloads > 0)) {
+        std::cout << "keys must be between 1 and " << max_key_columns << ", payloads at most "
+                  << max_payload_columns << std::endl;
+        return -1;
+    }
 
-    size_t const chunk_len = (v.size() - 1) / nw;
-    long remaining = static_cast<long>((v.size() - 1) % nw);
-    size_t offset = 0;
+    auto const binary = files.input.is_open() || !files.output.empty();
+    if (binary && keys > 0) {
+        std::cout << "The binary files hold plain arrays (no --keys)" << std::endl;
+        return -1;
+    }
 
-    std::thread controller(controller_body, std::cref(swaps), std::cref(barriers));
+    // NUMA mode: a chunk per worker on its node, exchanging only the boundary elements
+    auto const numa = options.count("numa") > 0;
+    if (numa && (keys > 0 || binary || policy.engine != oddeven::engine::transposition || policy.dirty
+                 || policy.depth > 0 || policy.rebalance > 0 || policy.park > 0)) {
+        std::cout << "The NUMA mode sorts plain arrays phase by phase, on fixed chunks"
+                  << " (no --keys, --input, --output, --engine, --dirty, --temporal, --rebalance, --park)"
+                  << std::endl;
+        return -1;
+    }
 
-    for (int i = 0; i < nw; ++i) {
-        workers.push_back(std::make_unique<std::thread>(
-                thread_body<vec_type>, i, ptr + offset, chunk_len + (remaining > 0), offset % 2, nw,
-                std::ref(phases), std::ref(swaps), std::cref(barriers)));
-        offset += chunk_len + (remaining > 0);
-        --remaining;
+    // Process mode: a worker process per chunk, on an array in shared memory, and the controller in this one
+    auto const processes = options.count("processes") > 0;
+    auto const process_error = oddeven::validate_processes(policy);
+    if (processes && (keys > 0 || numa || binary || !metrics_path.empty() || !process_error.empty())) {
+        std::cout << "The process mode sorts random arrays (no --keys, --numa, --input, --output, --metrics)"
+                  << (process_error.empty() ? "" : ": " + process_error) << std::endl;
+        return -1;
     }
 
-#ifdef LINUX_MACHINE
-    // Thread pinning
-    auto const hw_concurrency = std::thread::hardware_concurrency();
-    cpu_set_t cpuset;
-    CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    if (0 != pthread_setaffinity_np(controller.native_handle(), sizeof(cpu_set_t), &cpuset)) {
-        std::cout << "Error in thread pinning" << std::endl;
-        return EXIT_FAILURE;
+    // Stream mode: many arrays of n elements, sorted by the same threads
+    auto const stream = strtoul(get_option(options, "stream", "0").c_str(), nullptr, 10);
+    if (stream > 0 && (keys > 0 || numa || processes || binary || policy.engine != oddeven::engine::transposition
+                       || !metrics_path.empty())) {
+        std::cout << "The stream mode sorts random arrays with the transposition engine"
+                  << " (no --keys, --numa, --processes, --input, --output, --engine, --metrics)" << std::endl;
+        return -1;
     }
-    for (int i = 0; i < nw; ++i) {
-        CPU_ZERO(&cpuset);
-        CPU_SET((i + 1) % hw_concurrency, &cpuset);
-        if (0 != pthread_setaffinity_np(workers[i]->native_handle(), sizeof(cpu_set_t), &cpuset)) {
-            std::cout << "Error in thread pinning" << std::endl;
-            return EXIT_FAILURE;
-        }
+
+    // Batch mode: many arrays of 1 to n elements, an array per vector lane
+    auto const batch = strtoul(get_option(options, "batch", "0").c_str(), nullptr, 10);
+    if (batch > 0 && (keys > 0 || numa || processes || binary || stream > 0 || !metrics_path.empty())) {
+        std::cout << "The batch mode sorts random arrays"
+                  << " (no --keys, --numa, --processes, --input, --output, --stream, --metrics)" << std::endl;
+        return -1;
     }
-#endif
 
-    controller.join();
-    for (auto &thread : workers)
-        thread->join();
-    auto const duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::system_clock::now() - start_time).count();
+    // External mode: a file of n elements larger than the memory, sorted in place a block at a time
+    auto const external = get_option(options, "external", "");
+    auto const memory = strtoul(get_option(options, "memory", "1024").c_str(), nullptr, 10) << 20;
+    if (!external.empty() && (keys > 0 || numa || processes || binary || stream > 0 || batch > 0
+                              || !metrics_path.empty() || memory == 0)) {
+        std::cout << "The external mode sorts a plain file with some memory"
+                  << " (no --keys, --numa, --processes, --input, --output, --stream, --batch, --metrics)"
+                  << std::endl;
+        return -1;
+    }
+    auto const seed = argc > 3 ? static_cast<unsigned>(strtol(argv[3], nullptr, 10)) : std::random_device{}();
 
-    std::cout << "Time: " << duration << " ms" << std::endl;
+    distribution d;
+    auto const distribution_name = get_option(options, "distribution", "uniform");
+    if (!parse_distribution(distribution_name, d)) {
+        std::cout << "Unknown distribution " << distribution_name << std::endl;
+        return -1;
+    }
 
-    assert(std::is_sorted(v.begin(), v.end()));
+    // The element type is chosen at run time among the compiled instantiations
+    bool failed = false;
+    auto const sort = [&](auto element) {
+        if (!external.empty())
+            failed = !sort_file<decltype(element)>(external, n, memory, policy);
+        else if (processes)
+            failed = !sort_processes<decltype(element)>(n, seed, d, policy);
+        else if (batch > 0)
+            sort_batches<decltype(element)>(n, batch, seed, d, policy);
+        else if (stream > 0)
+            sort_stream<decltype(element)>(n, stream, seed, d, policy);
+        else
+            run<decltype(element)>(n, seed, keys, payloads, d, policy, metrics_path, numa, files);
+    };
+    if (!dispatch_type(files.type, sort)) {
+        std::cout << "Unknown type " << files.type << std::endl;
+        return -1;
+    }
 
-    return 0;
+    return failed ? -1 : 0;
 }
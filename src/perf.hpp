@@ -0,0 +1,233 @@
+/**
+ * @file   perf.hpp
+ * @brief  It contains the hardware counters of a worker (perf_event_open), compiled only with -DPERF_COUNTERS
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_PERF_HPP
+#define ODD_EVEN_SORT_PERF_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>  // strerror
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef LINUX_MACHINE
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+/**
+ * The counted events
+ */
+enum perf_event_index {
+    perf_cycles,
+    perf_instructions,
+    perf_l1d_misses,  // L1 data cache read misses
+    perf_llc_misses,  // Last level cache misses
+    perf_hitm,        // Loads served by a modified line of another core: the false sharing between the neighbours
+    perf_events
+};
+
+char const *const perf_event_names[perf_events] = {"cycles", "instructions", "l1d_misses", "llc_misses", "hitm"};
+
+/**
+ * The regions of a worker: the kernels, and the waits (the neighbours and the barrier)
+ */
+enum perf_region { perf_sort, perf_wait, perf_regions };
+
+char const *const perf_region_names[perf_regions] = {"sort", "wait"};
+
+/*
+ * HITM has no generic event: it's MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM (event 0xD2, umask 0x04) on the Intel cores
+ * from Skylake to Ice Lake. Elsewhere it's not counted, rather than counting something else.
+ */
+uint64_t constexpr perf_hitm_raw = 0x04D2;
+
+/**
+ * @return true if the CPU counts perf_hitm_raw as HITM: an Intel core from Skylake to Ice Lake, by its model
+ */
+inline bool perf_hitm_supported() {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned eax, ebx, ecx, edx;
+    if (!__builtin_cpu_is("intel") || !__get_cpuid(1, &eax, &ebx, &ecx, &edx) || ((eax >> 8) & 0xF) != 6)
+        return false;
+    switch (((eax >> 4) & 0xF) | ((eax >> 12) & 0xF0)) { // The model, with the extended model
+        case 0x4E: case 0x5E: case 0x55:            // Skylake client and server (also Cascade and Cooper Lake)
+        case 0x8E: case 0x9E: case 0xA5: case 0xA6: // Kaby, Coffee and Comet Lake
+        case 0x66:                                  // Cannon Lake
+        case 0x7D: case 0x7E: case 0x6A: case 0x6C: // Ice Lake client and server
+            return true;
+        default:
+            return false;
+    }
+#else
+    return false;
+#endif
+}
+
+/**
+ * The counters of a thread: one group, read at the end of every region.
+ * An event that can't be opened (no PMU, perf_event_paranoid, a container) is just missing from the report.
+ */
+class perf_group {
+public:
+    uint64_t totals[perf_regions][perf_events] = {}; // The counts of every region
+    bool available[perf_events] = {};
+    std::string error; // Why the leader couldn't be opened, if no event is available
+
+    perf_group() = default;
+    perf_group(perf_group const &) = delete;
+    perf_group &operator=(perf_group const &) = delete;
+
+    perf_group(perf_group &&other) noexcept {
+        *this = std::move(other);
+    }
+
+    perf_group &operator=(perf_group &&other) noexcept {
+        std::swap(fds, other.fds);
+        std::swap(slots, other.slots);
+        std::swap(last, other.last);
+        std::swap(totals, other.totals);
+        std::swap(available, other.available);
+        std::swap(error, other.error);
+        return *this;
+    }
+
+    ~perf_group() {
+#ifdef LINUX_MACHINE
+        for (auto fd : fds)
+            close(fd);
+#endif
+    }
+
+    /**
+     * @brief It opens the counters of the calling thread, and it starts them.
+     */
+    void open() {
+#ifdef LINUX_MACHINE
+        for (int e = 0; e < perf_events; ++e) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.exclude_kernel = 1; // Allowed with perf_event_paranoid up to 2
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            switch (e) {
+                case perf_cycles:
+                    attr.type = PERF_TYPE_HARDWARE, attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                    break;
+                case perf_instructions:
+                    attr.type = PERF_TYPE_HARDWARE, attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                    break;
+                case perf_l1d_misses:
+                    attr.type = PERF_TYPE_HW_CACHE;
+                    attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                  | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                    break;
+                case perf_llc_misses:
+                    attr.type = PERF_TYPE_HARDWARE, attr.config = PERF_COUNT_HW_CACHE_MISSES;
+                    break;
+                case perf_hitm:
+                    if (!perf_hitm_supported())
+                        continue;
+                    attr.type = PERF_TYPE_RAW, attr.config = perf_hitm_raw;
+                    break;
+            }
+            auto const leader = fds.empty() ? -1 : fds.front();
+            auto const fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+            if (fd < 0) {
+                if (fds.empty() && error.empty())
+                    error = strerror(errno);
+                continue;
+            }
+            fds.push_back(fd);
+            slots.push_back(e);
+            available[e] = true;
+        }
+        error = fds.empty() ? "perf_event_open: " + error : "";
+        last.assign(slots.size(), 0);
+#else
+        error = "hardware counters need a Linux machine";
+#endif
+    }
+
+    /**
+     * @brief It closes a region: the counts from the previous call go to it.
+     *
+     * @param region the region
+     */
+    void region_done(perf_region const region) {
+#ifdef LINUX_MACHINE
+        if (fds.empty())
+            return;
+        uint64_t values[perf_events + 1]; // The number of events, then the counts
+        if (read(fds.front(), values, sizeof(values)) < static_cast<ssize_t>((slots.size() + 1) * sizeof(uint64_t)))
+            return;
+        for (size_t i = 0; i < slots.size(); ++i) {
+            totals[region][slots[i]] += values[i + 1] - last[i];
+            last[i] = values[i + 1];
+        }
+#else
+        (void) region;
+#endif
+    }
+
+private:
+    std::vector<int> fds;        // The leader first
+    std::vector<int> slots;      // The event of every descriptor
+    std::vector<uint64_t> last;  // The counts at the end of the previous region
+};
+
+/**
+ * @brief It prints the counters of every worker, by region, and their sum.
+ *
+ * @param groups the counters of every worker
+ */
+inline void print_perf(std::vector<perf_group const *> const &groups) {
+    if (groups.empty())
+        return;
+    bool any = false;
+    for (auto group : groups)
+        for (auto available : group->available)
+            any = any || available;
+    if (!any) {
+        std::cout << "Hardware counters unavailable (" << groups.front()->error << ")" << std::endl;
+        return;
+    }
+
+    uint64_t sum[perf_regions][perf_events] = {};
+    auto const print = [&](std::string const &name, uint64_t const (&totals)[perf_regions][perf_events]) {
+        for (int r = 0; r < perf_regions; ++r) {
+            std::cout << name << ' ' << perf_region_names[r] << ':';
+            for (int e = 0; e < perf_events; ++e) {
+                std::cout << ' ' << perf_event_names[e] << '=';
+                if (groups.front()->available[e])
+                    std::cout << totals[r][e];
+                else
+                    std::cout << "n/a";
+            }
+            if (totals[r][perf_cycles] > 0)
+                std::cout << " ipc=" << static_cast<double>(totals[r][perf_instructions]) / totals[r][perf_cycles];
+            std::cout << std::endl;
+        }
+    };
+    for (size_t w = 0; w < groups.size(); ++w) {
+        for (int r = 0; r < perf_regions; ++r)
+            for (int e = 0; e < perf_events; ++e)
+                sum[r][e] += groups[w]->totals[r][e];
+        print("Worker " + std::to_string(w), groups[w]->totals);
+    }
+    if (groups.size() > 1)
+        print("Total", sum);
+}
+
+#endif // ODD_EVEN_SORT_PERF_HPP
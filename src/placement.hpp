@@ -0,0 +1,286 @@
+/**
+ * @file   placement.hpp
+ * @brief  It contains the thread placement: the CPU topology, the allowed CPUs and the CPU quota,
+ *         and the policies that map the controller and the workers on them
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_PLACEMENT_HPP
+#define ODD_EVEN_SORT_PLACEMENT_HPP
+
+#include <algorithm> // std::sort, std::min, std::max
+#include <cmath>     // std::ceil
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>     // std::tie
+#include <vector>
+
+#include <util.hpp>
+
+// The placement names accepted by --placement
+char constexpr placement_names[] = "compact|scatter|one-per-core|l2-pair";
+
+/**
+ * How the threads are mapped on the CPUs. Adjacent workers sort adjacent chunks, so they share
+ * the boundary elements: every policy but scatter keeps them on CPUs that share the caches.
+ */
+enum class placement {
+    compact,      // Fill a core (its hardware threads), then its L2, L3 and package neighbours
+    scatter,      // Round robin on the packages, then on the cores: the most memory bandwidth
+    one_per_core, // A hardware thread per core, in compact order; the siblings only when the cores are over
+    l2_pair       // Two workers on every L2, on different cores if possible, in compact order
+};
+
+/**
+ * @brief It parses a placement policy (see placement_names).
+ *
+ * @param name the name
+ * @param result the policy
+ * @return false if the name is unknown
+ */
+inline bool parse_placement(std::string const &name, placement &result) {
+    std::map<std::string, placement> const names{{"compact", placement::compact}, {"scatter", placement::scatter},
+                                                 {"one-per-core", placement::one_per_core},
+                                                 {"l2-pair", placement::l2_pair}};
+    auto const it = names.find(name);
+    if (it == names.end())
+        return false;
+    result = it->second;
+    return true;
+}
+
+/**
+ * Where a CPU is: every id is the one of its package, or the first CPU of the group sharing the resource
+ */
+struct cpu_location {
+    unsigned cpu;
+    unsigned package;
+    unsigned l3;
+    unsigned l2;
+    unsigned core;
+};
+
+/**
+ * @brief It reads a number from a file.
+ *
+ * @param path the file path
+ * @param fallback the value if the file can't be read
+ * @return the number
+ */
+inline long read_number(std::string const &path, long const fallback) {
+    std::ifstream file{path};
+    long value;
+    return file >> value ? value : fallback;
+}
+
+/**
+ * @brief It reads the first CPU of a CPU list file (like "4-5,68-69").
+ *
+ * @param path the file path
+ * @param fallback the value if the file can't be read
+ * @return the first CPU
+ */
+inline unsigned first_cpu(std::string const &path, unsigned const fallback) {
+    return static_cast<unsigned>(read_number(path, fallback)); // The lists are sorted
+}
+
+/**
+ * @brief It reads the topology of the CPUs I'm allowed to run on, from /sys/devices/system/cpu.
+ *        A missing piece of information puts every CPU (or core, for the L2) in its own group.
+ *
+ * @return the CPUs, in compact order (package, L3, L2, core, CPU)
+ */
+inline std::vector<cpu_location> read_topology() {
+    std::vector<unsigned> cpus;
+#ifdef LINUX_MACHINE
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &allowed) == 0)
+        for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            if (CPU_ISSET(cpu, &allowed))
+                cpus.push_back(cpu);
+#endif
+    for (unsigned cpu = 0; cpus.empty() && cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu)
+        cpus.push_back(cpu);
+
+    std::vector<cpu_location> topology;
+    for (auto cpu : cpus) {
+        auto const base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        auto const core = first_cpu(base + "/topology/thread_siblings_list", cpu);
+        auto const package = static_cast<unsigned>(read_number(base + "/topology/physical_package_id", 0));
+        cpu_location location{cpu, package, package, core, core}; // No shared L3: the package is the group
+        for (int index = 0; index < 8; ++index) {
+            auto const cache = base + "/cache/index" + std::to_string(index);
+            auto const level = read_number(cache + "/level", 0);
+            std::ifstream type_file{cache + "/type"};
+            std::string type;
+            if (level == 0 || !(type_file >> type) || type == "Instruction")
+                continue;
+            if (level == 2)
+                location.l2 = first_cpu(cache + "/shared_cpu_list", cpu);
+            else if (level == 3)
+                location.l3 = first_cpu(cache + "/shared_cpu_list", cpu);
+        }
+        topology.push_back(location);
+    }
+
+    std::sort(topology.begin(), topology.end(), [](cpu_location const &a, cpu_location const &b) {
+        return std::tie(a.package, a.l3, a.l2, a.core, a.cpu) < std::tie(b.package, b.l3, b.l2, b.core, b.cpu);
+    });
+    return topology;
+}
+
+/**
+ * @return the topology of the allowed CPUs, read once
+ */
+inline std::vector<cpu_location> const &topology() {
+    static auto const cpus = read_topology();
+    return cpus;
+}
+
+/**
+ * @brief It reads the CPU quota of my cgroup (v2 cpu.max, or v1 cpu.cfs_quota_us).
+ *
+ * @return the CPUs of the quota, rounded up (zero: no quota)
+ */
+inline int cpu_quota() {
+#ifdef LINUX_MACHINE
+    // cgroup v2: "0::/path" in /proc/self/cgroup, "quota period" (or "max period") in cpu.max
+    std::ifstream groups{"/proc/self/cgroup"};
+    std::string line, path;
+    while (std::getline(groups, line))
+        if (line.compare(0, 3, "0::") == 0)
+            path = line.substr(3);
+    for (auto const &file : {"/sys/fs/cgroup" + path + "/cpu.max", std::string{"/sys/fs/cgroup/cpu.max"}}) {
+        std::ifstream max{file};
+        std::string quota;
+        double period;
+        if (max >> quota >> period)
+            return quota == "max" || period <= 0 ? 0 : static_cast<int>(std::ceil(std::stod(quota) / period));
+    }
+
+    // cgroup v1: the quota is -1 without limits
+    auto const quota  = read_number("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", -1);
+    auto const period = read_number("/sys/fs/cgroup/cpu/cpu.cfs_period_us", -1);
+    if (quota > 0 && period > 0)
+        return static_cast<int>(std::ceil(static_cast<double>(quota) / period));
+#endif
+    return 0;
+}
+
+/**
+ * @return the CPUs I can use: the allowed ones, within the quota
+ */
+inline int effective_cpus() {
+    static int const cpus = [] {
+        auto const quota = cpu_quota();
+        auto const allowed = static_cast<int>(topology().size());
+        return std::max(1, quota > 0 ? std::min(quota, allowed) : allowed);
+    }();
+    return cpus;
+}
+
+/**
+ * @return the default number of workers: a CPU each, and one for the controller
+ */
+inline int default_workers() {
+    return std::max(1, effective_cpus() - 1);
+}
+
+/**
+ * @brief It orders the allowed CPUs by a policy: the threads take them in this order.
+ *
+ * @param policy the policy
+ * @return the CPUs
+ */
+inline std::vector<unsigned> placement_order(placement const policy) {
+    auto const &cpus = topology();
+    std::vector<unsigned> order;
+    std::vector<bool> taken(cpus.size(), false);
+    auto const take = [&](size_t i) {
+        order.push_back(cpus[i].cpu);
+        taken[i] = true;
+    };
+
+    switch (policy) {
+        case placement::compact:
+            for (size_t i = 0; i < cpus.size(); ++i)
+                take(i);
+            break;
+
+        case placement::scatter: {
+            // The k-th core of every package, then the (k+1)-th, with the siblings in the later rounds
+            std::map<unsigned, std::vector<size_t>> packages;
+            for (size_t i = 0; i < cpus.size(); ++i)
+                packages[cpus[i].package].push_back(i);
+            std::map<unsigned, std::vector<size_t>> rounds; // The cores of every package, one per round
+            for (auto const &package : packages) {
+                std::map<unsigned, unsigned> seen; // Core -> threads already in a round
+                std::vector<size_t> firsts, others;
+                for (auto i : package.second)
+                    (seen[cpus[i].core]++ == 0 ? firsts : others).push_back(i);
+                firsts.insert(firsts.end(), others.begin(), others.end());
+                for (size_t k = 0; k < firsts.size(); ++k)
+                    rounds[k].push_back(firsts[k]);
+            }
+            for (auto const &round : rounds)
+                for (auto i : round.second)
+                    take(i);
+            break;
+        }
+
+        case placement::one_per_core:
+            // The first thread of every core, then the siblings in compact order
+            for (size_t i = 0; i < cpus.size(); ++i)
+                if (i == 0 || cpus[i].core != cpus[i - 1].core)
+                    take(i);
+            break;
+
+        case placement::l2_pair:
+            // Two threads of every L2 group: on two cores if the group has them, else two siblings
+            for (size_t first = 0, last; first < cpus.size(); first = last) {
+                std::vector<size_t> firsts, others;
+                for (last = first; last < cpus.size() && cpus[last].l2 == cpus[first].l2; ++last)
+                    (last == first || cpus[last].core != cpus[last - 1].core ? firsts : others).push_back(last);
+                firsts.insert(firsts.end(), others.begin(), others.end());
+                for (size_t k = 0; k < std::min<size_t>(2, firsts.size()); ++k)
+                    take(firsts[k]);
+            }
+            break;
+    }
+    for (size_t i = 0; i < cpus.size(); ++i)
+        if (!taken[i])
+            take(i);
+    return order;
+}
+
+/**
+ * The CPUs of a run
+ */
+struct thread_placement {
+    unsigned controller;
+    std::vector<unsigned> workers;
+};
+
+/**
+ * @brief It places the controller and the workers: the workers take the CPUs in the order of the policy
+ *        (wrapping around if they are more than the CPUs), and the controller the last one,
+ *        so the pairs and the groups of the policy start from the first worker.
+ *
+ * @param nw the number of workers
+ * @param policy the policy
+ * @return the CPUs
+ */
+inline thread_placement place_threads(int const nw, placement const policy) {
+    auto const order = placement_order(policy);
+    auto const cpus = std::min(order.size(), static_cast<size_t>(effective_cpus()));
+    thread_placement result{order[cpus - 1], std::vector<unsigned>(std::max(nw, 0))};
+    for (int i = 0; i < nw; ++i)
+        result.workers[i] = order[i % cpus];
+    return result;
+}
+
+#endif // ODD_EVEN_SORT_PLACEMENT_HPP
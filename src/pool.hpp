@@ -0,0 +1,175 @@
+/**
+ * @file   pool.hpp
+ * @brief  It contains the persistent sorter: the workers and the controller outlive the sorts,
+ *         and they sort a stream of arrays
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_POOL_HPP
+#define ODD_EVEN_SORT_POOL_HPP
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <native.hpp>
+#include <oddeven.hpp>
+#include <placement.hpp>
+#include <sequential.hpp>
+#include <wait.hpp>
+
+namespace oddeven {
+
+/**
+ * A long-lived sorter: the workers and the controller are created and pinned once, and they sleep
+ * between the jobs instead of exiting. The jobs are sorted one at a time, in the submission order,
+ * by the transposition engine; an array with less than a pair per worker is sorted by the controller alone.
+ * submit and wait are meant for a single client thread.
+ *
+ * @tparam T the element type
+ */
+template <typename T>
+class sorter {
+public:
+    /**
+     * @brief It creates and pins the threads.
+     *
+     * @param p the policy, that must be valid (see validate), with the transposition engine.
+     *          The metrics of the workers are not collected.
+     */
+    explicit sorter(policy const &p = policy{}) : p{p}, nw{p.nw}, state{detail::make_state(p.nw, p)} {
+        threads.emplace_back(&sorter::controller_loop, this);
+        for (int i = 0; i < nw; ++i)
+            threads.emplace_back(&sorter::worker_loop, this, i);
+
+        if (p.pinning) {
+            auto const where = place_threads(nw, p.placement);
+            detail::pin(threads[0].native_handle(), where.controller);
+            for (int i = 0; i < nw; ++i)
+                detail::pin(threads[i + 1].native_handle(), where.workers[i]);
+        }
+    }
+
+    sorter(sorter const &) = delete;
+    sorter &operator=(sorter const &) = delete;
+
+    /**
+     * @brief It sorts the pending jobs, then it stops the threads.
+     */
+    ~sorter() {
+        push(job{nullptr, 0, true});
+        for (auto &thread : threads)
+            thread.join();
+    }
+
+    /**
+     * @brief It queues the sort of [first, last): the array must not be touched until wait returns.
+     *
+     * @param first the pointer to the first element
+     * @param last the pointer past the last element
+     */
+    void submit(T * const first, T * const last) {
+        push(job{first, static_cast<size_t>(last - first), false});
+    }
+
+    /**
+     * @brief It waits for the sort of every job submitted so far.
+     */
+    void wait() {
+        auto const target = __atomic_load_n(&submitted, __ATOMIC_ACQUIRE);
+        wait_until(&completed, [=](unsigned value) { return value == target; }, wait_policy::block);
+    }
+
+private:
+    struct job {
+        T *first;
+        size_t n;
+        bool stop; // The last job: the threads exit
+    };
+
+    /**
+     * @brief It queues a job, and it wakes the controller.
+     *
+     * @param next the job
+     */
+    void push(job const next) {
+        {
+            std::lock_guard<std::mutex> guard{queue_lock};
+            queue.push_back(next);
+        }
+        __atomic_add_fetch(&submitted, 1, __ATOMIC_RELEASE);
+        notify_all(&submitted, wait_policy::block);
+    }
+
+    /**
+     * @brief The controller: it takes the jobs, it starts the workers on them and it controls the runs.
+     */
+    void controller_loop() {
+        unsigned taken = 0;
+        while (true) {
+            wait_until(&submitted, [=](unsigned value) { return value != taken; }, wait_policy::block);
+            ++taken;
+            {
+                std::lock_guard<std::mutex> guard{queue_lock};
+                current = queue.front();
+                queue.pop_front();
+            }
+
+            if (current.stop || current.n > static_cast<size_t>(nw)) { // A pair per worker
+                state.reset();
+                depth = detail::fit_depth(p.depth, current.n, nw);
+                done = 0;
+                __atomic_add_fetch(&started, 1, __ATOMIC_RELEASE);
+                notify_all(&started, wait_policy::block);
+                if (current.stop)
+                    return;
+                controller_body(state, nw);
+                wait_until(word_of(done), [=](unsigned value) { return value == static_cast<unsigned>(nw); },
+                           wait_policy::block);
+            } else if (current.n > 1) {
+                sequential_sort(current.first, current.n, p.depth);
+            }
+
+            __atomic_add_fetch(&completed, 1, __ATOMIC_RELEASE);
+            notify_all(&completed, wait_policy::block);
+        }
+    }
+
+    /**
+     * @brief A worker: it sleeps until a job starts, and it sorts its chunk.
+     *
+     * @param thid the worker identifier
+     */
+    void worker_loop(int const thid) {
+        unsigned seen = 0;
+        while (true) {
+            wait_until(&started, [=](unsigned value) { return value != seen; }, wait_policy::block);
+            ++seen;
+            if (current.stop)
+                return;
+            detail::transposition_worker(thid, nw, current.first, current.n, depth, p, state);
+            if (++done == static_cast<unsigned>(nw))
+                notify_all(word_of(done), wait_policy::block);
+        }
+    }
+
+    policy const p;
+    int const nw;
+    native_state state;       // Reset before every job
+    std::mutex queue_lock;
+    std::deque<job> queue;
+    unsigned submitted = 0;   // The jobs submitted (the controller sleeps on it)
+    unsigned completed = 0;   // The jobs sorted (the client sleeps on it)
+    unsigned started = 0;     // The jobs given to the workers (they sleep on it)
+    std::atomic<unsigned> done{0}; // The workers done with the current job
+    job current{nullptr, 0, false};
+    unsigned depth = 0;       // The temporal blocking depth of the current job
+    std::vector<std::thread> threads; // The controller, then the workers
+};
+
+} // namespace oddeven
+
+#endif // ODD_EVEN_SORT_POOL_HPP
@@ -0,0 +1,311 @@
+/**
+ * @file   process.hpp
+ * @brief  It contains the process mode: the workers and the controller are processes sharing a POSIX shared memory
+ *         segment, with the array, their progress counters and the barrier, and the calling process supervises them
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_PROCESS_HPP
+#define ODD_EVEN_SORT_PROCESS_HPP
+
+#include <algorithm>  // std::fill
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>      // for ceil
+#include <csignal>    // kill
+#include <cstring>    // strerror
+#include <new>        // Placement new
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef LINUX_MACHINE
+#include <sys/prctl.h>
+#endif
+
+#include <barrier.hpp>
+#include <native.hpp>
+#include <oddeven.hpp>
+#include <placement.hpp>
+#include <wait.hpp>
+
+/**
+ * A fixed array of progress counters in the shared segment, read and written like the vectors of native_state
+ */
+struct counter_span {
+    unsigned *first;
+    size_t length;
+
+    unsigned &operator[](size_t const i) const {
+        return first[i];
+    }
+
+    size_t size() const {
+        return length;
+    }
+};
+
+/**
+ * The state shared by the worker processes and the controller: the members of native_state that thread_body and
+ * controller_body use, pointing in the shared segment (see shared_vector)
+ */
+struct process_state {
+    short cache_padding;
+    bool &finished;
+    wait_policy policy;
+    counter_span phases;  // The phases progress of every worker
+    counter_span swaps;   // The swaps of every worker in the current iteration
+    counter_span parking; // Empty: the workers don't park
+    barrier *sync;
+    METRIC(std::vector<worker_metrics> metrics;) // One per worker, private to its process: not collected
+};
+
+namespace oddeven {
+
+/**
+ * An array in a POSIX shared memory segment (shm_open), after the control block of the sort: the barrier,
+ * the end flag and the padded progress counters of the workers. The worker processes inherit the mapping,
+ * so they sort the array in place, and the calling process reads it afterwards.
+ *
+ * @tparam T the element type
+ */
+template <typename T>
+class shared_vector {
+public:
+    shared_vector() = default;
+    shared_vector(shared_vector const &) = delete;
+    shared_vector &operator=(shared_vector const &) = delete;
+
+    ~shared_vector() {
+        if (address != MAP_FAILED)
+            munmap(address, bytes);
+    }
+
+    /**
+     * @brief It creates the segment of n elements for the workers of a policy, not initialized: write it
+     *        with oddeven::fill, with the same policy, for the first touch.
+     *
+     * @param n the number of elements
+     * @param p the policy of the sort
+     * @return the error message, empty if the segment is mapped
+     */
+    std::string open(size_t const n, policy const &p) {
+        length = n;
+        nw = detail::transposition_workers(n, p);
+        cache_padding = ceil(static_cast<double>(p.cache_line) / sizeof(unsigned));
+
+        auto const page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        auto const round = [=](size_t size) { return (size + page - 1) / page * page; };
+        counters = round(sizeof(control));
+        offset = counters + round(2 * nw * cache_padding * sizeof(unsigned)); // The phases, then the swaps
+        bytes = offset + round(n * sizeof(T));
+
+        // The name is only needed to create the segment: unlinked at once, it lives as long as its mappings
+        static std::atomic<unsigned> segments{0};
+        auto const name = "/oddeven-" + std::to_string(getpid()) + "-" + std::to_string(segments++);
+        auto const fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0)
+            return name + ": " + strerror(errno);
+        shm_unlink(name.c_str());
+        if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            auto const error = name + ": " + strerror(errno);
+            close(fd);
+            return error;
+        }
+        address = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        auto const error = address == MAP_FAILED ? name + ": " + strerror(errno) : "";
+        close(fd);
+        return error;
+    }
+
+    /**
+     * @return the first element
+     */
+    T *data() const {
+        return reinterpret_cast<T *>(static_cast<char *>(address) + offset);
+    }
+
+    /**
+     * @return the number of elements
+     */
+    size_t size() const {
+        return length;
+    }
+
+    /**
+     * @return the number of worker processes of the sort
+     */
+    int workers() const {
+        return nw;
+    }
+
+private:
+    /**
+     * The first page of the segment
+     */
+    struct control {
+        alignas(central_barrier) char sync[sizeof(central_barrier)]; // Constructed by every sort
+        bool finished;
+    };
+
+    /**
+     * @brief It prepares the control block for a sort: a new barrier, the flag down and the counters to zero.
+     *
+     * @param policy the waiting policy, without sleeping: the futexes are private to a process
+     * @return the state, pointing in the segment
+     */
+    process_state make_state(wait_policy const policy) {
+        auto const block = static_cast<control *>(address);
+        auto const sync = new (block->sync) central_barrier(nw + 1, policy); // + 1 for the controller
+        block->finished = false;
+        auto const first = reinterpret_cast<unsigned *>(static_cast<char *>(address) + counters);
+        size_t const span = nw * cache_padding;
+        std::fill(first, first + 2 * span, 0);
+        return process_state{cache_padding, block->finished, policy, {first, span}, {first + span, span},
+                             {nullptr, 0}, sync METRIC(, std::vector<worker_metrics>(nw))};
+    }
+
+    template <typename U>
+    friend std::string sort(shared_vector<U> &data, policy const &p);
+
+    void *address = MAP_FAILED;
+    size_t bytes = 0;
+    size_t counters = 0; // The offset of the counters
+    size_t offset = 0;   // The offset of the elements
+    size_t length = 0;
+    int nw = 1;
+    short cache_padding = 1;
+};
+
+/**
+ * @brief It checks a policy for the process mode: only the phase by phase transposition engine runs in processes,
+ *        on the central barrier (the only one in the segment), and without sleeping.
+ *
+ * @param p the policy, valid (see validate)
+ * @return the error message, empty if the processes can run it
+ */
+inline std::string validate_processes(policy const &p) {
+    if (p.engine == engine::block || p.engine == engine::batcher || p.dirty || p.depth > 0 || p.rebalance > 0
+        || p.park > 0)
+        return "the worker processes run the transposition engine phase by phase, on fixed chunks";
+    if (p.barrier != "central")
+        return "the worker processes synchronize on the central barrier";
+    if (p.wait == "block")
+        return "the worker processes can't sleep on the private futexes: use spin, backoff or yield";
+    return "";
+}
+
+/**
+ * @brief It sorts a shared vector with the transposition engine: a worker process per chunk and a controller
+ *        process, forked by the calling process, that supervises them. The workers and the controller share
+ *        the array and the counters in the segment, so nothing is copied between the processes.
+ *        A child that crashes stops the sort: the supervisor kills the others, and it reports the failure.
+ *        The small arrays, and the single worker, are sorted by the calling process.
+ *
+ * @tparam T the element type
+ * @param data the shared vector, filled
+ * @param p the policy of the creation, valid (see validate and validate_processes); the metrics are not collected
+ * @return the error message, empty if the vector is sorted
+ */
+template <typename T>
+std::string sort(shared_vector<T> &data, policy const &p) {
+    auto const n = data.size();
+    auto const nw = data.workers();
+    if (n < 2)
+        return "";
+    if (n <= p.network) {
+        network_sort(data.data(), n);
+        return "";
+    }
+    if (nw == 1) {
+        sequential_sort(data.data(), n, p.depth);
+        return "";
+    }
+
+    // Busy waiting collapses when the processes are more than the cores: auto yields in that case
+    wait_policy wait = wait_policy::spin;
+    parse_wait_policy(p.wait, nw + 1, effective_cpus(), wait);
+    if (wait == wait_policy::block)
+        wait = wait_policy::yield;
+    auto state = data.make_state(wait);
+
+    // The children: the workers, then the controller
+    auto const starts = detail::chunk_starts(n, nw);
+    auto const where = place_threads(nw, p.placement);
+    auto const supervisor = getpid();
+    std::vector<pid_t> children;
+    std::vector<bool> reaped(nw + 1, false);
+    auto const kill_children = [&] {
+        for (size_t i = 0; i < children.size(); ++i) {
+            if (reaped[i])
+                continue;
+            kill(children[i], SIGKILL);
+            while (waitpid(children[i], nullptr, 0) < 0 && errno == EINTR)
+                ;
+        }
+    };
+    for (int i = 0; i <= nw; ++i) {
+        auto const pid = fork();
+        if (pid == 0) {
+#ifdef LINUX_MACHINE
+            prctl(PR_SET_PDEATHSIG, SIGKILL); // Not left spinning if the supervisor dies
+            if (getppid() != supervisor)
+                _exit(1);
+#else
+            (void) supervisor;
+#endif
+            if (p.pinning)
+                detail::pin(pthread_self(), i < nw ? where.workers[i] : where.controller);
+            if (i < nw) {
+                auto const offset = starts[i];
+                auto const end = (i < nw - 1 ? starts[i + 1] : n - 1) - offset; // The boundary element included
+                thread_body<T *, process_state>(i, data.data() + offset, end, offset % 2, nw, state);
+            } else {
+                controller_body<process_state>(state, nw);
+            }
+            _exit(0); // Without the destructors and the atexit handlers of the parent
+        }
+        if (pid < 0) { // The forked children wait for the missing ones at the first barrier
+            auto const error = std::string{"fork: "} + strerror(errno);
+            kill_children();
+            return error;
+        }
+        children.push_back(pid);
+    }
+
+    // The supervisor reaps the children as they exit, sleeping longer and longer meanwhile (up to a millisecond)
+    std::string error;
+    size_t running = children.size();
+    for (unsigned idle = 0; running > 0 && error.empty(); idle = std::min(idle + 1, 7u)) {
+        for (size_t i = 0; i < children.size() && error.empty(); ++i) {
+            int status = 0;
+            auto const pid = reaped[i] ? 0 : waitpid(children[i], &status, WNOHANG);
+            if (pid == 0 || (pid < 0 && errno == EINTR))
+                continue;
+            reaped[i] = true;
+            --running;
+            idle = 0;
+            if (pid < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                error = i < static_cast<size_t>(nw) ? "the worker process " + std::to_string(i) + " failed"
+                                                    : std::string{"the controller process failed"};
+        }
+        if (running > 0 && error.empty())
+            std::this_thread::sleep_for(std::chrono::microseconds(std::min(10u << idle, 1000u)));
+    }
+    if (!error.empty()) {
+        state.finished = true; // The survivors stop at their next check, if they get there before the signal
+        kill_children();
+    }
+    state.sync->~barrier();
+    return error;
+}
+
+} // namespace oddeven
+
+#endif // ODD_EVEN_SORT_PROCESS_HPP
@@ -7,33 +7,73 @@
 
 #include <algorithm> // std::is_sorted
 #include <cassert>
+#include <chrono>
 #include <iostream>
+#include <memory>    // std::unique_ptr
 #include <thread>
 #include <vector>
 
+#include <binary.hpp>
+#include <columns.hpp>
 #include <config.hpp>
+#include <distributions.hpp>
+#include <metrics.hpp>
+#include <placement.hpp>
+#include <sequential.hpp>
+#include <tiling.hpp>
 #include <util.hpp>
 
 /**
- * @brief It performs an odd or an even sorting phase on the array.
+ * @brief It creates the random array (or table) of the element type, and it sorts it.
  *
- * @tparam T the vector type
- * @param v the vector
- * @param start the phase (0: even, 1: odd)
- * @return the number of swaps
+ * @tparam T the element type
+ * @param n the length of the array
+ * @param seed the seed for the random generator
+ * @param keys the number of key columns (zero: a plain array)
+ * @param payloads the number of payload columns
+ * @param d the distribution of the values
+ * @param depth the temporal blocking depth (zero: phase by phase)
+ * @param files the input, sorted in place instead of the random array, and the output
  */
 template <typename T>
-unsigned odd_even_sort(std::vector<T> &v, short const start) {
-    unsigned swaps = 0;
-    for (size_t i = start; i < v.size() - 1; i += 2) {
-        auto first = v[i], second = v[i + 1];
-        auto cond = first > second;
-        v[i]     = cond ? second : first;
-        v[i + 1] = cond ? first : second;
-        if (v[i] != first)
-            swaps++;
+void run(size_t const n, unsigned const seed, size_t const keys, size_t const payloads, distribution const &d,
+         unsigned const depth, binary_files const &files) {
+    auto const min = element_traits<T>::min(), max = element_traits<T>::max();
+
+    std::vector<T> v;
+    std::unique_ptr<random_table<T>> table;
+    if (keys > 0)
+        table = std::make_unique<random_table<T>>(n, keys, payloads, min, max, seed, d);
+    else if (!files.input.is_open())
+        v = create_vector<T>(d, n, min, max, seed);
+    auto const first = files.input.is_open() ? files.input.data<T>() : v.data();
+
+#ifdef PERF_COUNTERS
+    std::vector<worker_metrics> counters(1);
+    counters[0].start();
+#endif
+    auto const start_time = std::chrono::steady_clock::now();
+    if (table)
+        sequential_sort(table->view(), n, depth);
+    else
+        sequential_sort(first, n, depth);
+    auto const duration = elapsed_ms(start_time);
+#ifdef PERF_COUNTERS
+    counters[0].phase_done(0, 0); // All the sort, no wait
+#endif
+
+    std::cout << "Time: " << duration << " ms" << std::endl;
+#ifdef PERF_COUNTERS
+    print_counters(counters);
+#endif
+
+    assert(table ? table->is_sorted() : std::is_sorted(first, first + n));
+
+    if (!files.output.empty()) {
+        auto const error = write_binary(files.output, first, n, files.type, files.header);
+        if (!error.empty())
+            std::cout << error << std::endl;
     }
-    return swaps;
 }
 
 /**
@@ -42,44 +82,66 @@ unsigned odd_even_sort(std::vector<T> &v, short const start) {
  * @return the exit status
  */
 int main(int argc, char const *argv[]) {
+    auto const options = parse_options(argc, argv);
     if (argc < 2) {
         std::cout << "Usage is " << argv[0]
-                  << " n [seed]" << std::endl;
+                  << " n [seed] [--temporal[=depth|auto]] [--keys=columns] [--payloads=columns]"
+                  << " [--type=" << element_types << "] [--distribution=" << distribution_names << "]"
+                  << " [--input=file (n 0: its length)] [--map=private|shared] [--output=file] [--header]"
+                  << std::endl;
         return -1;
     }
 
-    auto const n = strtol(argv[1], nullptr, 10);
+    // Temporal blocking: depth phases are applied to every L1-sized tile (zero: phase by phase)
+    auto const depth = options.count("temporal") ? parse_depth(get_option(options, "temporal", "")) : 0;
 
-    std::vector<vec_type> v;
-    if (argc > 2)
-        v = create_random_vector<vec_type>(n, MIN, MAX, strtol(argv[2], nullptr, 10));
-    else
-        v = create_random_vector<vec_type>(n, MIN, MAX);
+    auto n = strtol(argv[1], nullptr, 10);
+    auto const seed = argc > 2 ? static_cast<unsigned>(strtol(argv[2], nullptr, 10)) : std::random_device{}();
+
+    // Key-value mode: the rows of a table, sorted by the key columns, with the payload columns alongside
+    auto const keys     = strtoul(get_option(options, "keys", "0").c_str(), nullptr, 10);
+    auto const payloads = strtoul(get_option(options, "payloads", "0").c_str(), nullptr, 10);
+    if (keys > max_key_columns || payloads > max_payload_columns || (keys == 0 && payloads > 0)) {
+        std::cout << "keys must be between 1 and " << max_key_columns << ", payloads at most "
+                  << max_payload_columns << std::endl;
+        return -1;
+    }
+
+    // Binary mode: the array of a file, mapped and sorted in place, and the sorted array written to a file
+    binary_files files;
+    auto const error = open_binary_files(options, n, files);
+    if (!error.empty()) {
+        std::cout << error << std::endl;
+        return -1;
+    }
+    if (keys > 0 && (files.input.is_open() || !files.output.empty())) {
+        std::cout << "The binary files hold plain arrays (no --keys)" << std::endl;
+        return -1;
+    }
 
 #ifdef LINUX_MACHINE
-    // Dirty trick for getting the current thread handle (works only on Linux)
-    auto thread_id = std::this_thread::get_id();
-    auto native_handle = *reinterpret_cast<std::thread::native_handle_type*>(&thread_id);
+    // On the CPU of the controller of par: an allowed one
     cpu_set_t cpuset;
     CPU_ZERO(&cpuset);
-    CPU_SET(0, &cpuset);
-    if (0 != pthread_setaffinity_np(native_handle, sizeof(cpu_set_t), &cpuset)) {
+    CPU_SET(place_threads(0, placement::compact).controller, &cpuset);
+    if (0 != pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset)) {
         std::cout << "Error in thread pinning" << std::endl;
         return EXIT_FAILURE;
     }
 #endif
 
-    unsigned swaps;
-    auto const start_time = std::chrono::system_clock::now();
-    do {
-        swaps  = odd_even_sort(v, 1); // Odd phase
-        swaps += odd_even_sort(v, 0); // Even phase
-    } while (swaps > 0);
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::system_clock::now() - start_time).count();
-
-    std::cout << "Time: " << duration << " ms" << std::endl;
+    distribution d;
+    auto const distribution_name = get_option(options, "distribution", "uniform");
+    if (!parse_distribution(distribution_name, d)) {
+        std::cout << "Unknown distribution " << distribution_name << std::endl;
+        return -1;
+    }
 
-    assert(std::is_sorted(v.begin(), v.end()));
+    // The element type is chosen at run time among the compiled instantiations
+    auto const sort = [&](auto element) { run<decltype(element)>(n, seed, keys, payloads, d, depth, files); };
+    if (!dispatch_type(files.type, sort)) {
+        std::cout << "Unknown type " << files.type << std::endl;
+        return -1;
+    }
     return 0;
 }
@@ -0,0 +1,42 @@
+/**
+ * @file   sequential.hpp
+ * @brief  It contains the business logic of the sequential implementation
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_SEQUENTIAL_HPP
+#define ODD_EVEN_SORT_SEQUENTIAL_HPP
+
+#include <cstddef>
+
+#include <kernel.hpp>
+#include <tiling.hpp>
+
+/**
+ * @brief It sorts the array in the calling thread.
+ *
+ * @tparam T the vector pointer type
+ * @param v the pointer to the vector
+ * @param n the length of the vector
+ * @param depth the temporal blocking depth (zero or one: phase by phase, odd: rounded down)
+ */
+template <typename T>
+void sequential_sort(T const v, size_t const n, unsigned const depth) {
+    if (n < 2)
+        return;
+
+    unsigned swaps;
+    if (depth >= 2) {
+        do { // An even depth: a block without swaps had both the phases
+            swaps = temporal_block(v, 1, n - 1, depth & ~1u, false, false); // Starting from an odd phase
+        } while (swaps > 0);
+    } else {
+        do {
+            swaps  = odd_even_sort(v, 1, n - 1); // Odd phase
+            swaps += odd_even_sort(v, 0, n - 1); // Even phase
+        } while (swaps > 0);
+    }
+}
+
+#endif // ODD_EVEN_SORT_SEQUENTIAL_HPP
@@ -0,0 +1,259 @@
+/**
+ * @file   simd.hpp
+ * @brief  It contains the per-type register operations of the vectorized sorting phase
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_SIMD_HPP
+#define ODD_EVEN_SORT_SIMD_HPP
+
+#include <cstdint>
+
+#if !defined(SCALAR_KERNEL) && (defined(__AVX512F__) || defined(__AVX2__))
+#include <immintrin.h>
+#endif
+
+/**
+ * The register operations of an element type: the primary template has none,
+ * so the type is sorted by the scalar kernel.
+ * A specialization provides the register type, the load/store on the raw bits, and sort_pairs(x),
+ * that moves the min of every pair to the even lane and the max to the odd one.
+ * The widest instruction set available for the type is picked: 8 and 16-bit types need AVX-512BW for 512-bit registers.
+ *
+ * @tparam T the element type
+ */
+template <typename T>
+struct simd_ops {
+    static bool constexpr enabled = false;
+};
+
+#if !defined(SCALAR_KERNEL) && (defined(__AVX512F__) || defined(__AVX2__))
+
+/**
+ * The raw bits of a 256-bit register
+ */
+struct avx2_bits {
+    using reg = __m256i;
+    static bool constexpr enabled = true;
+
+    static reg load(void const *p) { return _mm256_loadu_si256(static_cast<__m256i const *>(p)); }
+
+    static void store(void *p, reg x) { _mm256_storeu_si256(static_cast<__m256i *>(p), x); }
+
+    static reg zero() { return _mm256_setzero_si256(); }
+
+    // The changed bits: a pair has been swapped only if its lanes changed
+    static reg changes(reg acc, reg x, reg sorted) { return _mm256_or_si256(acc, _mm256_xor_si256(x, sorted)); }
+
+    static bool any(reg acc) { return !_mm256_testz_si256(acc, acc); }
+};
+
+#ifdef __AVX512F__
+/**
+ * The raw bits of a 512-bit register
+ */
+struct avx512_bits {
+    using reg = __m512i;
+    static bool constexpr enabled = true;
+
+    static reg load(void const *p) { return _mm512_loadu_si512(p); }
+
+    static void store(void *p, reg x) { _mm512_storeu_si512(p, x); }
+
+    static reg zero() { return _mm512_setzero_si512(); }
+
+    static reg changes(reg acc, reg x, reg sorted) { return _mm512_or_si512(acc, _mm512_xor_si512(x, sorted)); }
+
+    static bool any(reg acc) { return _mm512_test_epi64_mask(acc, acc) != 0; }
+};
+#endif
+
+/*
+ * The masked forms spare the min/max blend (and an undefined source operand).
+ * The floating point min and max take the mate first: on equal values (like -0 and +0) they return x,
+ * so an already ordered pair is never rewritten.
+ */
+
+#if defined(__AVX512BW__)
+template <>
+struct simd_ops<int8_t> : avx512_bits {
+    static reg sort_pairs(reg x) {
+        auto const mate = _mm512_or_si512(_mm512_slli_epi16(x, 8), _mm512_srli_epi16(x, 8)); // Exchange the partners
+        return _mm512_mask_max_epi8(_mm512_mask_min_epi8(x, 0x5555555555555555, x, mate),
+                                    0xAAAAAAAAAAAAAAAA, x, mate);
+    }
+};
+
+template <>
+struct simd_ops<uint8_t> : avx512_bits {
+    static reg sort_pairs(reg x) {
+        auto const mate = _mm512_or_si512(_mm512_slli_epi16(x, 8), _mm512_srli_epi16(x, 8));
+        return _mm512_mask_max_epu8(_mm512_mask_min_epu8(x, 0x5555555555555555, x, mate),
+                                    0xAAAAAAAAAAAAAAAA, x, mate);
+    }
+};
+
+template <>
+struct simd_ops<int16_t> : avx512_bits {
+    static reg sort_pairs(reg x) {
+        auto const mate = _mm512_mask_rol_epi32(x, 0xFFFF, x, 16); // Exchange the partners
+        return _mm512_mask_max_epi16(_mm512_mask_min_epi16(x, 0x55555555, x, mate), 0xAAAAAAAA, x, mate);
+    }
+};
+
+template <>
+struct simd_ops<uint16_t> : avx512_bits {
+    static reg sort_pairs(reg x) {
+        auto const mate = _mm512_mask_rol_epi32(x, 0xFFFF, x, 16); // Exchange the partners
+        return _mm512_mask_max_epu16(_mm512_mask_min_epu16(x, 0x55555555, x, mate), 0xAAAAAAAA, x, mate);
+    }
+};
+#else
+template <>
+struct simd_ops<int8_t> : avx2_bits {
+    static reg sort_pairs(reg x) {
+        auto const mate = _mm256_or_si256(_mm256_slli_epi16(x, 8), _mm256_srli_epi16(x, 8)); // Exchange the partners
+        return _mm256_blendv_epi8(_mm256_min_epi8(x, mate), _mm256_max_epi8(x, mate),
+                                  _mm256_set1_epi16(static_cast<short>(0xFF00)));
+    }
+};
+
+template <>
+struct simd_ops<uint8_t> : avx2_bits {
+    static reg sort_pairs(reg x) {
+        auto const mate = _mm256_or_si256(_mm256_slli_epi16(x, 8), _mm256_srli_epi16(x, 8));
+        return _mm256_blendv_epi8(_mm256_min_epu8(x, mate), _mm256_max_epu8(x, mate),
+                                  _mm256_set1_epi16(static_cast<short>(0xFF00)));
+    }
+};
+
+template <>
+struct simd_ops<int16_t> : avx2_bits {
+    static reg sort_pairs(reg x) {
+        auto const mate = _mm256_or_si256(_mm256_slli_epi32(x, 16), _mm256_srli_epi32(x, 16));
+        return _mm256_blend_epi16(_mm256_min_epi16(x, mate), _mm256_max_epi16(x, mate), 0xAA);
+    }
+};
+
+template <>
+struct simd_ops<uint16_t> : avx2_bits {
+    static reg sort_pairs(reg x) {
+        auto const mate = _mm256_or_si256(_mm256_slli_epi32(x, 16), _mm256_srli_epi32(x, 16));
+        return _mm256_blend_epi16(_mm256_min_epu16(x, mate), _mm256_max_epu16(x, mate), 0xAA);
+    }
+};
+#endif
+
+#ifdef __AVX512F__
+template <>
+struct simd_ops<int32_t> : avx512_bits {
+    static reg sort_pairs(reg x) {
+        auto const mate = _mm512_mask_shuffle_epi32(x, 0xFFFF, x, _MM_PERM_CDAB);
+        return _mm512_mask_max_epi32(_mm512_mask_min_epi32(x, 0x5555, x, mate), 0xAAAA, x, mate);
+    }
+};
+
+template <>
+struct simd_ops<uint32_t> : avx512_bits {
+    static reg sort_pairs(reg x) {
+        auto const mate = _mm512_mask_shuffle_epi32(x, 0xFFFF, x, _MM_PERM_CDAB);
+        return _mm512_mask_max_epu32(_mm512_mask_min_epu32(x, 0x5555, x, mate), 0xAAAA, x, mate);
+    }
+};
+
+template <>
+struct simd_ops<int64_t> : avx512_bits {
+    static reg sort_pairs(reg x) {
+        auto const mate = _mm512_mask_shuffle_epi32(x, 0xFFFF, x, _MM_PERM_BADC);
+        return _mm512_mask_max_epi64(_mm512_mask_min_epi64(x, 0x55, x, mate), 0xAA, x, mate);
+    }
+};
+
+template <>
+struct simd_ops<uint64_t> : avx512_bits {
+    static reg sort_pairs(reg x) {
+        auto const mate = _mm512_mask_shuffle_epi32(x, 0xFFFF, x, _MM_PERM_BADC);
+        return _mm512_mask_max_epu64(_mm512_mask_min_epu64(x, 0x55, x, mate), 0xAA, x, mate);
+    }
+};
+
+template <>
+struct simd_ops<float> : avx512_bits {
+    static reg sort_pairs(reg x) {
+        auto const xf   = _mm512_castsi512_ps(x);
+        auto const mate = _mm512_mask_permute_ps(xf, 0xFFFF, xf, 0xB1);
+        return _mm512_castps_si512(
+                _mm512_mask_max_ps(_mm512_mask_min_ps(xf, 0x5555, mate, xf), 0xAAAA, mate, xf));
+    }
+};
+
+template <>
+struct simd_ops<double> : avx512_bits {
+    static reg sort_pairs(reg x) {
+        auto const xd   = _mm512_castsi512_pd(x);
+        auto const mate = _mm512_mask_permute_pd(xd, 0xFF, xd, 0x55);
+        return _mm512_castpd_si512(_mm512_mask_max_pd(_mm512_mask_min_pd(xd, 0x55, mate, xd), 0xAA, mate, xd));
+    }
+};
+#else
+template <>
+struct simd_ops<int32_t> : avx2_bits {
+    static reg sort_pairs(reg x) {
+        auto const mate = _mm256_shuffle_epi32(x, 0xB1);
+        return _mm256_blend_epi32(_mm256_min_epi32(x, mate), _mm256_max_epi32(x, mate), 0xAA);
+    }
+};
+
+template <>
+struct simd_ops<uint32_t> : avx2_bits {
+    static reg sort_pairs(reg x) {
+        auto const mate = _mm256_shuffle_epi32(x, 0xB1);
+        return _mm256_blend_epi32(_mm256_min_epu32(x, mate), _mm256_max_epu32(x, mate), 0xAA);
+    }
+};
+
+/**
+ * AVX2 has no 64-bit min/max: the compare selects the partners, the unsigned one after flipping the sign bits
+ */
+template <>
+struct simd_ops<int64_t> : avx2_bits {
+    static reg sort_pairs(reg x) {
+        auto const mate    = _mm256_shuffle_epi32(x, 0x4E);
+        auto const greater = _mm256_cmpgt_epi64(x, mate);
+        return _mm256_blend_epi32(_mm256_blendv_epi8(x, mate, greater), _mm256_blendv_epi8(mate, x, greater), 0xCC);
+    }
+};
+
+template <>
+struct simd_ops<uint64_t> : avx2_bits {
+    static reg sort_pairs(reg x) {
+        auto const sign    = _mm256_set1_epi64x(INT64_MIN);
+        auto const mate    = _mm256_shuffle_epi32(x, 0x4E);
+        auto const greater = _mm256_cmpgt_epi64(_mm256_xor_si256(x, sign), _mm256_xor_si256(mate, sign));
+        return _mm256_blend_epi32(_mm256_blendv_epi8(x, mate, greater), _mm256_blendv_epi8(mate, x, greater), 0xCC);
+    }
+};
+
+template <>
+struct simd_ops<float> : avx2_bits {
+    static reg sort_pairs(reg x) {
+        auto const xf   = _mm256_castsi256_ps(x);
+        auto const mate = _mm256_permute_ps(xf, 0xB1);
+        return _mm256_castps_si256(_mm256_blend_ps(_mm256_min_ps(mate, xf), _mm256_max_ps(mate, xf), 0xAA));
+    }
+};
+
+template <>
+struct simd_ops<double> : avx2_bits {
+    static reg sort_pairs(reg x) {
+        auto const xd   = _mm256_castsi256_pd(x);
+        auto const mate = _mm256_permute_pd(xd, 0x5);
+        return _mm256_castpd_si256(_mm256_blend_pd(_mm256_min_pd(mate, xd), _mm256_max_pd(mate, xd), 0xA));
+    }
+};
+#endif
+
+#endif
+
+#endif // ODD_EVEN_SORT_SIMD_HPP
@@ -0,0 +1,111 @@
+/**
+ * @file   tiling.hpp
+ * @brief  It contains the temporally blocked (cache-tiled) sorting phases
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_TILING_HPP
+#define ODD_EVEN_SORT_TILING_HPP
+
+#include <algorithm> // std::min, std::max
+#include <cstddef>
+#include <cstdlib>   // std::strtoul
+#include <string>
+
+#include <kernel.hpp>
+
+// Bytes of a tile: half of the 32KB L1, the other half is left for the skew and the rest of the program
+size_t constexpr tile_bytes = 16 * 1024;
+
+// Phases fused per tile when the depth is automatically chosen
+unsigned constexpr auto_depth = 16;
+
+/**
+ * @brief It performs a sorting phase on the pairs with the left index in [lo, hi).
+ *
+ * @tparam T the vector pointer type
+ * @param v the pointer to the vector
+ * @param phase the phase (odd or even)
+ * @param lo the first pair (included)
+ * @param hi the last pair (excluded)
+ * @return non-zero if at least one swap has been performed
+ */
+template <typename T>
+unsigned odd_even_sort_range(T const v, short const phase, long const lo, long const hi) {
+    auto const start = lo + ((lo & 1) != phase);
+    return hi > start ? odd_even_sort(v + start, 0, hi - start) : 0;
+}
+
+/**
+ * @brief It applies depth consecutive sorting phases to the pairs in [0, end), an L1-sized tile at a time.
+ *        The phase j works on the pairs in [j * shrink_left, end - j * shrink_right): an edge shrinks when
+ *        the pairs beyond it belong to a neighbour, and the missing triangle is filled by temporal_triangle.
+ *        The tiles are skewed back by one pair per phase (wavefront), so every dependency of a pair has been
+ *        computed before it, and the result is identical to the phase-by-phase algorithm.
+ *
+ * @tparam T the vector pointer type
+ * @param v the pointer to the vector
+ * @param phase the first phase (odd or even), then they alternate
+ * @param end the end of the array
+ * @param depth the number of phases
+ * @param shrink_left if true, the left edge shrinks
+ * @param shrink_right if true, the right edge shrinks
+ * @return non-zero if at least one swap has been performed in the last two phases
+ */
+template <typename T>
+unsigned temporal_block(T const v, short const phase, size_t const end, unsigned const depth,
+                        bool const shrink_left, bool const shrink_right) {
+    long const phases = depth;
+    long const tile   = std::max<long>(tile_bytes / row_bytes(v), 2 * phases);
+    long const total  = static_cast<long>(end) + phases; // The last tile must reach the end in every phase
+    unsigned swaps = 0;
+
+    for (long first = 0; first < total; first += tile) {
+        auto const last = std::min(first + tile, total);
+        for (long j = 0; j < phases; ++j) {
+            auto const lo = std::max(first - j, shrink_left ? j : 0);
+            auto const hi = std::min(last - j, static_cast<long>(end) - (shrink_right ? j : 0));
+            auto const phase_swaps = odd_even_sort_range(v, (phase + j) % 2, lo, hi);
+            if (j + 2 >= phases)
+                swaps |= phase_swaps;
+        }
+    }
+    return swaps;
+}
+
+/**
+ * @brief It applies depth consecutive sorting phases to the triangle between two shrinking trapezoids:
+ *        the phase j works on the pairs in [boundary - j, boundary + j).
+ *
+ * @tparam T the vector pointer type
+ * @param v the pointer to the vector
+ * @param phase the first phase (odd or even), then they alternate
+ * @param boundary the position of the element shared by the two trapezoids
+ * @param depth the number of phases
+ * @return non-zero if at least one swap has been performed in the last two phases
+ */
+template <typename T>
+unsigned temporal_triangle(T const v, short const phase, size_t const boundary, unsigned const depth) {
+    long const phases = depth, middle = boundary;
+    unsigned swaps = 0;
+    for (long j = 1; j < phases; ++j) {
+        auto const phase_swaps = odd_even_sort_range(v, (phase + j) % 2, middle - j, middle + j);
+        if (j + 2 >= phases)
+            swaps |= phase_swaps;
+    }
+    return swaps;
+}
+
+/**
+ * @brief It parses the temporal blocking depth option.
+ *
+ * @param value the option value: empty or "auto" for the automatic depth, or the number of phases
+ * @return the depth, rounded to an even number of phases (at least two)
+ */
+inline unsigned parse_depth(std::string const &value) {
+    unsigned const depth = value.empty() || value == "auto" ? auto_depth : std::strtoul(value.c_str(), nullptr, 10);
+    return std::max<unsigned>(2, depth & ~1u);
+}
+
+#endif // ODD_EVEN_SORT_TILING_HPP
@@ -8,10 +8,58 @@
 #ifndef ODD_EVEN_SORT_UTIL_HPP
 #define ODD_EVEN_SORT_UTIL_HPP
 
-#include <algorithm> // std::generate
+#include <chrono>
+#include <cstdint>
+#include <cstring>     // std::strncmp
+#include <map>
+#include <memory>      // std::allocator
 #include <random>
+#include <string>
+#include <thread>
+#include <type_traits> // std::is_integral
+#include <utility>     // std::forward
 #include <vector>
 
+#ifdef LINUX_MACHINE
+#include <sched.h>     // sched_getaffinity
+#endif
+
+/**
+ * @brief The SplitMix64 finalizer: a bijective mix of the 64 bits.
+ *
+ * @param x the input
+ * @return the mixed bits
+ */
+inline uint64_t splitmix64(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Counter-based random generator: the value of an index depends only on the seed and the index,
+ *        so any thread can generate any part of the vector, and the vector doesn't depend on the threads.
+ *
+ * @tparam T the element type
+ * @param seed the seed for the random generator
+ * @param index the index of the element
+ * @param min the lower bound for the values
+ * @param max the upper bound for the values
+ * @return the value of the index, uniform in [min, max]
+ */
+template <typename T>
+T random_value(unsigned seed, size_t index, T min, T max) {
+    uint64_t constexpr gamma = 0x9E3779B97F4A7C15; // The SplitMix64 increment
+    auto const bits = splitmix64(splitmix64(seed + gamma) + (index + 1) * gamma);
+
+    if (!std::is_integral<T>::value)
+        return static_cast<T>(min + (max - min) * ((bits >> 11) * (1.0 / 9007199254740992.0))); // 53 bits in [0, 1)
+
+    // Two's complement arithmetic: it works also for the signed types, and a zero range is the whole 64-bit range
+    auto const range = static_cast<uint64_t>(max) - static_cast<uint64_t>(min) + 1;
+    return static_cast<T>(static_cast<uint64_t>(min) + (range == 0 ? bits : bits % range));
+}
+
 /**
  * @brief Generates a vector of random numbers.
  *
@@ -23,15 +71,96 @@
  * @return the vector
  */
 template <typename T>
-std::vector<T> create_random_vector(size_t n, int min, int max, unsigned seed = std::random_device{}()) {
-    std::mt19937 gen{seed};
-
-    std::uniform_real_distribution<> dis(min, max);
-
+std::vector<T> create_random_vector(size_t n, T min, T max, unsigned seed = std::random_device{}()) {
     std::vector<T> v(n);
-    std::generate(v.begin(), v.end(), [&]{ return dis(gen); });
+    for (size_t i = 0; i < n; ++i)
+        v[i] = random_value(seed, i, min, max);
 
     return v;
 }
 
+/**
+ * An allocator that doesn't initialize the elements: a vector created with it is first written (touched)
+ * by its user, so the pages are allocated on the NUMA node of the thread that writes them.
+ *
+ * @tparam T the element type
+ */
+template <typename T>
+struct untouched_allocator : std::allocator<T> {
+    template <typename U>
+    struct rebind {
+        using other = untouched_allocator<U>;
+    };
+
+    untouched_allocator() = default;
+
+    template <typename U>
+    untouched_allocator(untouched_allocator<U> const &) noexcept {}
+
+    template <typename U>
+    void construct(U *p) noexcept {
+        ::new (static_cast<void *>(p)) U; // Default initialization: nothing for the arithmetic types
+    }
+
+    template <typename U, typename... Args>
+    void construct(U *p, Args &&... args) {
+        ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+    }
+};
+
+// A vector whose elements are not written on creation
+template <typename T>
+using untouched_vector = std::vector<T, untouched_allocator<T>>;
+
+/**
+ * @brief Measures the time elapsed from a starting point, on a monotonic clock.
+ *
+ * @param start the starting point, from std::chrono::steady_clock::now()
+ * @return the elapsed milliseconds, with the resolution of the clock
+ */
+inline double elapsed_ms(std::chrono::steady_clock::time_point const start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Extracts the "--name=value" options from the command line.
+ *        The options are removed from argv, so the positional arguments keep their indexes.
+ *
+ * @param argc the number of arguments, updated without the options
+ * @param argv the arguments
+ * @return the map from the option names to their values
+ */
+inline std::map<std::string, std::string> parse_options(int &argc, char const *argv[]) {
+    std::map<std::string, std::string> options;
+    int positional = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--", 2) != 0) {
+            argv[positional++] = argv[i];
+            continue;
+        }
+        std::string const option{argv[i] + 2};
+        auto const equal = option.find('=');
+        if (equal == std::string::npos)
+            options[option] = "";
+        else
+            options[option.substr(0, equal)] = option.substr(equal + 1);
+    }
+    argc = positional;
+    return options;
+}
+
+/**
+ * @brief Reads an option extracted by parse_options.
+ *
+ * @param options the options map
+ * @param name the option name
+ * @param fallback the value to return if the option is missing
+ * @return the option value
+ */
+inline std::string get_option(std::map<std::string, std::string> const &options,
+                              std::string const &name, std::string const &fallback) {
+    auto const it = options.find(name);
+    return it == options.end() ? fallback : it->second;
+}
+
 #endif // ODD_EVEN_SORT_UTIL_HPP
@@ -0,0 +1,159 @@
+/**
+ * @file   wait.hpp
+ * @brief  It contains the waiting policies for the barriers and the neighbours synchronization
+ * @author Michele Zoncheddu
+ */
+
+
+#ifndef ODD_EVEN_SORT_WAIT_HPP
+#define ODD_EVEN_SORT_WAIT_HPP
+
+#include <algorithm> // std::min
+#include <atomic>
+#include <climits>   // INT_MAX
+#include <string>
+#include <thread>
+
+#ifdef LINUX_MACHINE
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * How a thread waits for a condition:
+ * spin:    busy waiting, the lowest latency when every thread has its own core
+ * backoff: busy waiting with pause instructions, doubling their number at every check
+ * yield:   busy waiting for a while, then yielding the core at every check
+ * block:   busy waiting for a while, then sleeping on a futex until the word changes
+ */
+enum class wait_policy { spin, backoff, yield, block };
+
+// Checks of the condition before yielding or sleeping
+unsigned constexpr spin_limit = 1024;
+
+// Maximum number of pause instructions between two checks
+unsigned constexpr backoff_limit = 1024;
+
+/**
+ * @brief It parses a waiting policy.
+ *
+ * @param name the policy name, "auto" chooses block if the threads are more than the cores
+ * @param threads the number of threads that will wait
+ * @param cpus the number of cores available for the threads
+ * @param policy set to the parsed policy
+ * @return false if the name is unknown
+ */
+inline bool parse_wait_policy(std::string const &name, int const threads, int const cpus, wait_policy &policy) {
+    if (name == "auto")
+        policy = threads > cpus ? wait_policy::block : wait_policy::spin;
+    else if (name == "spin")
+        policy = wait_policy::spin;
+    else if (name == "backoff")
+        policy = wait_policy::backoff;
+    else if (name == "yield")
+        policy = wait_policy::yield;
+    else if (name == "block")
+        policy = wait_policy::block;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * @return the number of threads sleeping on a futex, so the wakers can skip the system call
+ */
+inline std::atomic<int> &sleepers() {
+    static std::atomic<int> count{0};
+    return count;
+}
+
+/**
+ * @brief It tells the core that the thread is busy waiting.
+ */
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    __asm__("nop");
+#endif
+}
+
+/**
+ * @brief One step of the busy waiting, for the conditions that can't sleep on a single word.
+ *
+ * @param policy the waiting policy (block yields after the spin limit)
+ * @param checks the number of checks already done, updated
+ */
+inline void relax(wait_policy const policy, unsigned &checks) {
+    switch (policy) {
+        case wait_policy::spin:
+            __asm__("nop"); // To force the compiler to don't "optimize" the waiting loop
+            break;
+        case wait_policy::backoff:
+            for (unsigned i = 0; i < std::min(1u << std::min(checks, 10u), backoff_limit); ++i)
+                cpu_relax();
+            break;
+        case wait_policy::yield:
+        case wait_policy::block:
+            if (checks < spin_limit)
+                cpu_relax();
+            else
+                std::this_thread::yield();
+            break;
+    }
+    ++checks;
+}
+
+/**
+ * @brief It waits until the word satisfies the condition.
+ *
+ * @tparam Done the condition type
+ * @param word the word written by the other thread, that calls notify_all after every change
+ * @param done the condition on the word value
+ * @param policy the waiting policy
+ */
+template <typename Done>
+void wait_until(unsigned *word, Done const &done, wait_policy const policy) {
+    unsigned checks = 0;
+    unsigned value;
+    while (!done(value = __atomic_load_n(word, __ATOMIC_ACQUIRE))) {
+#ifdef LINUX_MACHINE
+        if (policy == wait_policy::block && checks >= spin_limit) {
+            ++sleepers();
+            // It doesn't sleep if the word is not value anymore
+            syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0);
+            --sleepers();
+            continue;
+        }
+#endif
+        relax(policy, checks);
+    }
+}
+
+/**
+ * @brief It wakes the threads sleeping on a word, after its change.
+ *
+ * @param word the changed word
+ * @param policy the waiting policy
+ */
+inline void notify_all(unsigned *word, wait_policy const policy) {
+#ifdef LINUX_MACHINE
+    if (policy != wait_policy::block)
+        return;
+    // Paired with the sleepers increment: either I see the sleeper, or it sees the new value
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers() > 0)
+        syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+/**
+ * @brief The futex word of an atomic.
+ */
+inline unsigned *word_of(std::atomic<unsigned> &atomic) {
+    static_assert(sizeof(std::atomic<unsigned>) == sizeof(unsigned), "The atomic must be a plain word");
+    return reinterpret_cast<unsigned *>(&atomic);
+}
+
+#endif // ODD_EVEN_SORT_WAIT_HPP